@@ -0,0 +1,59 @@
+#include "Aot.h"
+#include "Chip8.h"
+#include "Hash.h"
+#include <dlfcn.h>          // dlopen
+#include <string.h>         // memcmp
+#include <unordered_map>
+
+const unsigned int AOT_START_ADDR = 0x200;  // Where ROMs (and so compiled code) start
+
+// Every registered module, by ROM hash
+static std::unordered_map<uint64_t, AotModule const*>& Modules() {
+    static std::unordered_map<uint64_t, AotModule const*> modules;
+    return modules;
+}
+
+// Generated code can't call Chip8::Execute directly (it lives in a different library), so it gets this instead
+static void ExecuteOpcode(Chip8& chip8, uint16_t opcode) {
+    chip8.Execute(opcode);
+}
+
+/* ------------------------- REGISTRATION ------------------------ */
+bool LoadAotModule(char const* filename) {
+    void* library = dlopen(filename, RTLD_NOW | RTLD_LOCAL);  // Never closed, blocks can be running at any time
+    if (!library) {return false;}
+
+    AotModuleEntry entry = reinterpret_cast<AotModuleEntry>(dlsym(library, "chip8_aot_module"));
+    if (!entry) {return false;}
+
+    AotModule const* module = entry(&ExecuteOpcode);
+    if (!module || module->abiVersion != AOT_ABI_VERSION || module->chip8Size != sizeof(Chip8)) {
+        return false;                       // Generated by (or compiled against) a different version
+    }
+    RegisterAotModule(module);
+    return true;
+}
+
+void RegisterAotModule(AotModule const* module) {
+    Modules()[module->romHash] = module;
+}
+
+/* ---------------------------- LOOKUP --------------------------- */
+AotModule const* FindAotModule(uint8_t const* rom, size_t size) {
+    auto found = Modules().find(Fnv1a(rom, size));
+    if (found == Modules().end() || found->second->romSize != size) {return nullptr;}
+    if (memcmp(found->second->rom, rom, size) != 0) {return nullptr;}  // Same hash, different ROM
+    return found->second;
+}
+
+// Used after memory has been replaced wholesale (e.g. by a savestate): one lookup by hash, then only the compiled bytes need to match
+AotModule const* FindAotModule(uint64_t romHash, uint8_t const* memory) {
+    auto found = Modules().find(romHash);
+    if (found == Modules().end()) {return nullptr;}
+    AotModule const* module = found->second;
+    for (uint32_t i = 0; i < module->romSize; ++i) {
+        uint32_t address = AOT_START_ADDR + i;
+        if (module->codeMap[address] && memory[address] != module->rom[i]) {return nullptr;}  // The ROM has rewritten its code
+    }
+    return module;
+}
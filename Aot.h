@@ -0,0 +1,38 @@
+#ifndef AOT_H
+#define AOT_H
+#include <cstddef>
+#include <cstdint>
+
+class Chip8;
+
+const uint32_t AOT_ABI_VERSION = 2;     // Bump whenever AotModule or the way generated code uses Chip8 changes
+
+/*
+A compiled block runs a run of instructions that start at one address, straight from native code.
+It is given the number of instructions it may run (budget) and returns how many are left afterwards.
+If the budget is too small for the block it returns budget untouched, and the caller interprets instead.
+*/
+typedef uint32_t (*AotBlock)(Chip8& chip8, uint32_t budget);
+typedef void (*AotExecute)(Chip8& chip8, uint16_t opcode);  // Runs one opcode through the interpreter (for the complicated ones)
+
+// What tools/chip8_aot.cpp generates for one ROM
+struct AotModule {
+    uint32_t abiVersion;                // AOT_ABI_VERSION the module was generated for
+    uint32_t chip8Size;                 // sizeof(Chip8) the module was compiled against, catches mismatched builds
+    uint64_t romHash;                   // Fnv1a of the ROM file
+    uint32_t romSize;                   // Size of the ROM file
+    uint8_t const* rom;                 // The ROM itself, to check memory still holds the code that was compiled
+    AotBlock const* blocks;             // 4096 entries, indexed by address, nullptr where nothing was compiled
+    uint8_t const* codeMap;             // 4096 entries, non-zero for every byte of a compiled instruction
+};
+
+// Signature of chip8_aot_module(), the function every generated module exports
+typedef AotModule const* (*AotModuleEntry)(AotExecute execute);
+
+// NOTE: The registry isn't locked, so load/register modules before starting emulators on other threads
+bool LoadAotModule(char const* filename);                           // dlopen a compiled module and register it
+void RegisterAotModule(AotModule const* module);                    // Register a module that is already in memory
+AotModule const* FindAotModule(uint8_t const* rom, size_t size);    // The module compiled from this exact ROM, or nullptr
+AotModule const* FindAotModule(uint64_t romHash, uint8_t const* memory);  // The module for romHash, if its code still matches a Chip8's memory
+
+#endif
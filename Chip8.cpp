@@ -1,7 +1,15 @@
 #include "Chip8.h"
+#include "Tracer.h"
+#include "Metrics.h"
+#include "Aot.h"
+#include "Hash.h"
+#include "Debugger.h"
 #include <fstream>  // File operations
-#include <chrono>   // Time functions
-#include <string.h> // To use memset
+#include <string.h> // To use memset and memcpy
+#include <type_traits>  // std::is_trivially_copyable
+
+// Copying a Chip8 must stay a plain memcpy (run-ahead and forking rely on it), so no members that own memory
+static_assert(std::is_trivially_copyable<Chip8>::value, "Chip8 must be trivially copyable");
 
 const unsigned int START_ADDR = 0x200;          // Set the start address for the PC, 0x000 to 0x1FF are reserved
 const unsigned int FONTSET_START_ADDR = 0x50;   // Set the start address for where the font is stored
@@ -21,7 +29,7 @@ The first row is the hex number 0xF0.
 We will store the whole character set using 16 sets of 5 bytes.
 */
 const unsigned int FONTSET_SIZE = 80;
-uint8_t fontset[FONTSET_SIZE] =
+const uint8_t fontset[FONTSET_SIZE] =
 {
 	0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
 	0x20, 0x60, 0x20, 0x20, 0x70, // 1
@@ -41,76 +49,138 @@ uint8_t fontset[FONTSET_SIZE] =
 	0xF0, 0x80, 0xF0, 0x80, 0x80  // F
 };
 
-/* ------------------------- CONSTRUCTOR ------------------------- */
-Chip8::Chip8()
-// Initialisers
-: randGen(std::chrono::system_clock::now().time_since_epoch().count()),  // Seed the RNG using the current time
-  randByte(0, 255)  // Generate a random num one byte in size (0 to 255)
-{
-    // Create the function pointer table
-    table[0x0] = &Chip8::Table0;                // Points to the table for opcodes starting 0
-    table[0x1] = &Chip8::OP_1nnn;
-    table[0x2] = &Chip8::OP_2nnn;
-    table[0x3] = &Chip8::OP_3xkk;
-    table[0x4] = &Chip8::OP_4xkk;
-    table[0x5] = &Chip8::OP_5xy0;
-    table[0x6] = &Chip8::OP_6xkk;
-    table[0x7] = &Chip8::OP_7xkk;
-    table[0x8] = &Chip8::Table8;                // Points to the table for opcodes starting 8
-    table[0x9] = &Chip8::OP_9xy0;
-    table[0xA] = &Chip8::OP_Annn;
-    table[0xB] = &Chip8::OP_Bnnn;
-    table[0xC] = &Chip8::OP_Cxkk;
-    table[0xD] = &Chip8::OP_Dxyn;
-    table[0xE] = &Chip8::TableE;                // Points to the table for opcodes starting E
-    table[0xF] = &Chip8::TableF;                // Points to the table for opcodes starting F
-
-    for (size_t i = 0; i <= 0xE; i++) {         // Fill all opcodes in deeper dimensions with the null opcode
-        table0[i] = &Chip8::OP_NULL;
-        table8[i] = &Chip8::OP_NULL;
-        tableE[i] = &Chip8::OP_NULL;
-    }
+/* ------------------- FUNCTION POINTER TABLES ------------------- */
+/*
+The tables are the same for every Chip8, so they are static and built at compile time.
+Each one starts out full of OP_NULL and then the valid opcodes are filled in, exactly like the old constructor did.
+*/
+constexpr std::array<Chip8::Chip8Func, 0xF + 1> Chip8::table = {
+    &Chip8::Table0,                             // Points to the table for opcodes starting 0
+    &Chip8::OP_1nnn,
+    &Chip8::OP_2nnn,
+    &Chip8::OP_3xkk,
+    &Chip8::OP_4xkk,
+    &Chip8::OP_5xy0,
+    &Chip8::OP_6xkk,
+    &Chip8::OP_7xkk,
+    &Chip8::Table8,                             // Points to the table for opcodes starting 8
+    &Chip8::OP_9xy0,
+    &Chip8::OP_Annn,
+    &Chip8::OP_Bnnn,
+    &Chip8::OP_Cxkk,
+    &Chip8::OP_Dxyn,
+    &Chip8::TableE,                             // Points to the table for opcodes starting E
+    &Chip8::TableF                              // Points to the table for opcodes starting F
+};
 
-    // Fill valid opcodes in 00 table
-    table0[0x0] = &Chip8::OP_00E0;
-    table0[0xE] = &Chip8::OP_00EE;
-
-    // Fill valid opcodes in 8xy table
-    table8[0x0] = &Chip8::OP_8xy0;
-    table8[0x1] = &Chip8::OP_8xy1;
-    table8[0x2] = &Chip8::OP_8xy2;
-    table8[0x3] = &Chip8::OP_8xy3;
-    table8[0x4] = &Chip8::OP_8xy4;
-    table8[0x5] = &Chip8::OP_8xy5;
-    table8[0x6] = &Chip8::OP_8xy6;
-    table8[0x7] = &Chip8::OP_8xy7;
-    table8[0xE] = &Chip8::OP_8xyE;
-
-    // Fill valid opcodes in E table
-    tableE[0x1] = &Chip8::OP_ExA1;
-    tableE[0xE] = &Chip8::OP_Ex9E;
-
-    for (size_t i = 0; i <= 0x65; i++) {         // Iterate to fill the F table with null opcode
-        tableF[i] = &Chip8::OP_NULL;
-    }
+// Fill valid opcodes in 00 table
+constexpr std::array<Chip8::Chip8Func, 0xE + 1> Chip8::table0 = [] {
+    std::array<Chip8Func, 0xE + 1> t{};
+    for (auto& entry : t) {entry = &Chip8::OP_NULL;}
+    t[0x0] = &Chip8::OP_00E0;
+    t[0xE] = &Chip8::OP_00EE;
+    return t;
+}();
+
+// Fill valid opcodes in 8xy table
+constexpr std::array<Chip8::Chip8Func, 0xE + 1> Chip8::table8 = [] {
+    std::array<Chip8Func, 0xE + 1> t{};
+    for (auto& entry : t) {entry = &Chip8::OP_NULL;}
+    t[0x0] = &Chip8::OP_8xy0;
+    t[0x1] = &Chip8::OP_8xy1;
+    t[0x2] = &Chip8::OP_8xy2;
+    t[0x3] = &Chip8::OP_8xy3;
+    t[0x4] = &Chip8::OP_8xy4;
+    t[0x5] = &Chip8::OP_8xy5;
+    t[0x6] = &Chip8::OP_8xy6;
+    t[0x7] = &Chip8::OP_8xy7;
+    t[0xE] = &Chip8::OP_8xyE;
+    return t;
+}();
+
+// Fill valid opcodes in E table
+constexpr std::array<Chip8::Chip8Func, 0xE + 1> Chip8::tableE = [] {
+    std::array<Chip8Func, 0xE + 1> t{};
+    for (auto& entry : t) {entry = &Chip8::OP_NULL;}
+    t[0x1] = &Chip8::OP_ExA1;
+    t[0xE] = &Chip8::OP_Ex9E;
+    return t;
+}();
+
+// Fill valid opcodes in F table
+constexpr std::array<Chip8::Chip8Func, 0x65 + 1> Chip8::tableF = [] {
+    std::array<Chip8Func, 0x65 + 1> t{};
+    for (auto& entry : t) {entry = &Chip8::OP_NULL;}
+    t[0x07] = &Chip8::OP_Fx07;
+    t[0x0A] = &Chip8::OP_Fx0A;
+    t[0x15] = &Chip8::OP_Fx15;
+    t[0x18] = &Chip8::OP_Fx18;
+    t[0x1E] = &Chip8::OP_Fx1E;
+    t[0x29] = &Chip8::OP_Fx29;
+    t[0x33] = &Chip8::OP_Fx33;
+    t[0x55] = &Chip8::OP_Fx55;
+    t[0x65] = &Chip8::OP_Fx65;
+    return t;
+}();
+
+/*
+Fused pairs, picked by running tools/chip8_profile.cpp over ROMS/: the most common back-to-back pairs whose first
+instruction never moves the PC (so both always run), from loop counters, delay timer waits and runs of loads.
+Pairs with a Dxyn in them are left out on purpose, the draw costs so much more than the dispatch that fusing
+it saved nothing. Every other entry is nullptr, meaning "no fusion, just run the first instruction normally".
+*/
+constexpr std::array<Chip8::Chip8Fused, 0xFF + 1> Chip8::fusedTable = [] {
+    std::array<Chip8Fused, 0xFF + 1> t{};
+    for (auto& entry : t) {entry = nullptr;}
+    t[0x73] = &Chip8::FUSED_7xkk_3xkk;
+    t[0x74] = &Chip8::FUSED_7xkk_4xkk;
+    t[0xF3] = &Chip8::FUSED_Fx07_3xkk;          // Only for Fx07, DecodeFusedPairs checks the rest of the opcode
+    t[0x66] = &Chip8::FUSED_6xkk_6xkk;
+    t[0x67] = &Chip8::FUSED_6xkk_7xkk;
+    return t;
+}();
 
-    // Fill valid opcodes in F table
-    tableF[0x07] = &Chip8::OP_Fx07;
-    tableF[0x0A] = &Chip8::OP_Fx0A;
-    tableF[0x15] = &Chip8::OP_Fx15;
-    tableF[0x18] = &Chip8::OP_Fx18;
-    tableF[0x1E] = &Chip8::OP_Fx1E;
-    tableF[0x29] = &Chip8::OP_Fx29;
-    tableF[0x33] = &Chip8::OP_Fx33;
-    tableF[0x55] = &Chip8::OP_Fx55;
-    tableF[0x65] = &Chip8::OP_Fx65;
+/* ------------------------- CONSTRUCTOR ------------------------- */
+Chip8::Chip8(uint32_t seed) {
+    Reset(seed);
+}
+
+/* ---------------------------- RESET ---------------------------- */
+// Puts the machine back to how it is at power-on, so a pooled Chip8 can be reused without building a new one
+void Chip8::Reset(uint32_t seed) {
+    memset(registers, 0, sizeof(registers));
+    memset(memory, 0, sizeof(memory));
+    memset(stack, 0, sizeof(stack));
+    memset(keypad, 0, sizeof(keypad));
+    memset(video, 0, sizeof(video));
+    index = 0;
+    sp = 0;
+    delayTimer = 0;
+    soundTimer = 0;
+    opcode = 0;
+    randState = seed ? seed : 1;                // xorshift gets stuck on 0, so never let the state be 0
+    aot = nullptr;                              // Compiled code belongs to a ROM, and memory no longer holds one
+    romHash = 0;
+    dirtyPages = ALL_PAGES_DIRTY;               // Everything has just been rewritten
+    tracer = nullptr;                           // Attachments belong to whoever had this instance before (e.g. through Chip8Pool)...
+    metrics = nullptr;
+    debugger = nullptr;
+    fusion = false;                             // ...and so do settings
+    memset(fusedStarts, 0, sizeof(fusedStarts));
 
     pc = START_ADDR;  // Set the starting address of the Chip8 to 0x200
 
     // Load font set into the memory
-    for (unsigned int i = 0; i < FONTSET_SIZE; ++i) {
-        memory[FONTSET_START_ADDR + i] = fontset[i];
-    }
+    memcpy(&memory[FONTSET_START_ADDR], fontset, FONTSET_SIZE);
+}
+
+/* ----------------------------- RNG ----------------------------- */
+// xorshift32: a handful of shifts instead of a full std::random engine, and the whole state is one uint32_t
+uint8_t Chip8::RandByte() {
+    randState ^= randState << 13;
+    randState ^= randState >> 17;
+    randState ^= randState << 5;
+    return randState >> 24;                     // Use the top byte, it is the most random
 }
 
 /* - FUNCTIONS FOR ACCESSING DIMENSIONS OF FUNCTION POINTER TABLE - */
@@ -145,31 +215,154 @@ void Chip8::Cycle() {
     pc += 2;
 
     // Decode and Execute
-    ((*this).*(table[(opcode & 0xF000u) >> 12u]))();  // Finds the relevent function and calls it from the function pointer table (See Chip8::Table0 for syntax explanation)
+    if (tracer) {                               // When tracing is off this is one never-taken branch
+        tracer->Begin(pc - 2, opcode, index, registers);  // Before executing, so an instruction that crashes is still the last thing in the dump
+        ((*this).*(table[(opcode & 0xF000u) >> 12u]))();
+        tracer->Finish(index, registers);
+    } else {
+        ((*this).*(table[(opcode & 0xF000u) >> 12u]))();  // Finds the relevent function and calls it from the function pointer table (See Chip8::Table0 for syntax explanation)
+    }
 
-    if (delayTimer > 0) {--delayTimer;}  // Decrement delay timer if it has a value
-    if (soundTimer > 0) {--soundTimer;}  // Decrement sound timer if it has a value
+    TickTimers();
+}
+
+// Decode and execute an opcode without fetching it, used by compiled code for opcodes it doesn't handle itself
+void Chip8::Execute(uint16_t op) {
+    opcode = op;
+    ((*this).*(table[(opcode & 0xF000u) >> 12u]))();  // See Chip8::Cycle
 }
 
 /* ----------------- FUNCTION TO LOAD A ROM FILE ----------------- */
-void Chip8::LoadROM(char const* filename) {
+bool Chip8::LoadROM(char const* filename) {
     // Open binary file and move pointer to end
-    std::fstream file(filename, std::ios::binary | std::ios::ate);  // Obj called file of type std::fstream
-
-    if (file.is_open()){
-        // Find size of file and create buffer of this size
-        std::streampos size = file.tellg(); // .tellg() returns the current position of the file pointer (in this case the end)
-        char* buffer = new char[size];      // Buffer now points to the first addr of some contiguous memory the same size as the ROM
-        
-        // Read file to the buffer
-        file.seekg(0, std::ios::beg);       // With no offset (go all the way), seek the pointer to the beginning of the file
-        file.read(buffer, size);            // Read the file to the buffer array, for the size of the file
-        file.close();                       // We are done with the file! Let's close it!
-
-        // Load the buffer into the Chip8's memory
-        for (long i=0; i < size; ++i) {memory[START_ADDR + i] = buffer[i];}
-
-        delete[] buffer;                    // Free the buffer memory
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);  // Obj called file of type std::ifstream (fstream needs ios::in to read)
+
+    if (!file.is_open()) {return false;}
+
+    // Find size of file and create buffer of this size
+    std::streampos size = file.tellg(); // .tellg() returns the current position of the file pointer (in this case the end)
+    char* buffer = new char[size];      // Buffer now points to the first addr of some contiguous memory the same size as the ROM
+
+    // Read file to the buffer
+    file.seekg(0, std::ios::beg);       // With no offset (go all the way), seek the pointer to the beginning of the file
+    file.read(buffer, size);            // Read the file to the buffer array, for the size of the file
+    file.close();                       // We are done with the file! Let's close it!
+
+    // Load the buffer into the Chip8's memory
+    bool loaded = LoadROM(reinterpret_cast<uint8_t const*>(buffer), size);
+
+    delete[] buffer;                    // Free the buffer memory
+    return loaded;
+}
+
+// Load a ROM that is already in memory (e.g. handed over by another language through the C API)
+bool Chip8::LoadROM(uint8_t const* data, size_t size) {
+    if (size > sizeof(memory) - START_ADDR) {return false;}  // Too big to fit between 0x200 and the end of memory
+    memcpy(&memory[START_ADDR], data, size);
+    if (fusion) {DecodeFusedPairs();}
+    romHash = Fnv1a(data, size);
+    aot = FindAotModule(data, size);            // Use compiled code if this ROM has some
+    dirtyPages = ALL_PAGES_DIRTY;
+    return true;
+}
+
+/* ------------------- RUN SEVERAL CYCLES AT ONCE ---------------- */
+// Headless stepping: runs cycles instructions back to back with nothing else in between
+void Chip8::Run(uint32_t cycles) {
+    while (cycles > 0) {
+        // Debugging: stop at breakpoints, and take none of the shortcuts below, since they would run straight past them
+        if (debugger) {
+            if (debugger->IsTrap(pc)) {debugger->Break(*this);}
+            Cycle();
+            --cycles;
+            continue;
+        }
+        // Compiled code skips Cycle(), so it can't be used while tracing
+        if (aot && !tracer) {
+            // Trampoline: every block sets pc and returns, and the next one is looked up here, so however many
+            // blocks run back to back (even a block that jumps to itself) the C++ stack never grows
+            uint32_t before = cycles;
+            AotBlock block;
+            while (cycles > 0 && aot && (block = aot->blocks[pc & 0x0FFFu])) {
+                uint32_t left = block(*this, cycles);
+                if (left == cycles) {break;}    // Not enough budget left for this block
+                cycles = left;
+            }
+            if (cycles != before) {continue;}   // Blocks ran, carry on from wherever they finished
+        }
+        // Fused pairs also skip Cycle(), and need both instructions to fit in the budget. fusedStarts is redone whenever
+        // memory is loaded or written, so a set bit always means the pair is there, and anywhere else this is one bit test
+        if (fusion && !tracer && cycles >= 2 && ((fusedStarts[(pc & 0x0FFFu) >> 6u] >> (pc & 63u)) & 1u)) {
+            uint16_t first = (memory[pc] << 8u) | memory[pc + 1];
+            uint16_t second = (memory[pc + 2] << 8u) | memory[pc + 3];
+            ((*this).*(fusedTable[((first >> 8u) & 0xF0u) | (second >> 12u)]))(first, second);
+            cycles -= 2;
+            continue;
+        }
+        Cycle();                                // No compiled block or fused pair here, interpret one instruction
+        --cycles;
+    }
+}
+
+void Chip8::SetFusion(bool on) {
+    fusion = on;
+    if (on) {DecodeFusedPairs();}               // Writes made while it was off didn't keep fusedStarts up to date
+}
+
+bool Chip8::Fusion() const {
+    return fusion;
+}
+
+// Mark every address in from..to where the two opcodes starting there make a pair in fusedTable
+void Chip8::DecodeFusedPairs(int from, int to) {
+    if (from < 0) {from = 0;}
+    if (to > static_cast<int>(sizeof(memory)) - 4) {to = sizeof(memory) - 4;}  // The pair needs 4 bytes
+    for (int address = from; address <= to; ++address) {
+        uint64_t bit = 1ull << (address & 63);
+        uint8_t pair = (memory[address] & 0xF0u) | (memory[address + 2] >> 4u);
+        bool fuses = fusedTable[pair] && (pair >> 4u != 0xF || memory[address + 1] == 0x07);  // Fx07 is the only F opcode that fuses
+        if (fuses) {fusedStarts[address >> 6] |= bit;}
+        else {fusedStarts[address >> 6] &= ~bit;}
+    }
+}
+
+// Set the dirty bits for the memory pages from address to address + count - 1
+void Chip8::MarkMemoryDirty(uint16_t address, unsigned int count) {
+    unsigned int first = address / STATE_PAGE_SIZE;
+    unsigned int last = (address + count - 1) / STATE_PAGE_SIZE;
+    for (unsigned int page = first; page <= last; ++page) {dirtyPages |= 1ull << (page % MEMORY_PAGE_COUNT);}
+}
+
+// Everything that has to notice a memory write: forks, fused pairs, compiled code (self-modifying code) and watchpoints
+void Chip8::MemoryWritten(uint16_t address, unsigned int count) {
+    MarkMemoryDirty(address, count);
+    if (fusion) {DecodeFusedPairs(address - 3, address + count - 1);}  // Pairs starting up to 3 bytes before the write include it
+    if (aot) {CheckCodeWrite(address, count);}
+    if (debugger) {debugger->MemoryWritten(*this, address, count);}
+}
+
+// For code outside the Chip8 (e.g. the C API) that wants to change memory, so nothing goes on using what was there before
+bool Chip8::WriteMemory(uint16_t address, uint8_t const* data, size_t count) {
+    if (address > sizeof(memory) || count > sizeof(memory) - address) {return false;}
+    if (count == 0) {return true;}
+    memcpy(&memory[address], data, count);
+    MemoryWritten(address, count);
+    return true;
+}
+
+// Once per instruction, from Cycle() and the fused handlers
+void Chip8::TickTimers() {
+    if (delayTimer > 0) {--delayTimer;}  // Decrement delay timer if it has a value
+    if (soundTimer > 0) {--soundTimer;}  // Decrement sound timer if it has a value
+}
+
+// Called after memory is written: if the ROM has overwritten its own compiled code, the compiled code is now wrong
+void Chip8::CheckCodeWrite(uint16_t address, unsigned int count) {
+    for (unsigned int i = 0; i < count; ++i) {
+        if (aot->codeMap[(address + i) & 0x0FFFu]) {
+            aot = nullptr;                      // Interpret from now on
+            return;
+        }
     }
 }
 
@@ -177,6 +370,7 @@ void Chip8::LoadROM(char const* filename) {
 // 00E0 -> CLS: Clears the display
 void Chip8::OP_00E0() {
     memset(video, 0, sizeof(video));    // Sets entire video buffer (display) to 0s
+    dirtyPages |= ALL_PAGES_DIRTY & ~((1ull << MEMORY_PAGE_COUNT) - 1);  // Every video page
 }
 
 // 00EE -> RET: Returns from a subroutine
@@ -348,7 +542,7 @@ void Chip8::OP_Bnnn() {
 void Chip8::OP_Cxkk() {
     uint8_t Vx = (opcode & 0x0F00u) >> 8u;  // Extract Vx from opcode
     uint8_t byte = opcode & 0x00FFu;        // Extract kk from opcode
-    registers[Vx] = randByte(randGen) & byte;
+    registers[Vx] = RandByte() & byte;
 }
 
 // Dxyn -> DRW Vx Vy nibble: Draw sprite in index reg, at (Vx,Vy). (Collision? Stored in VF)
@@ -362,6 +556,9 @@ void Chip8::OP_Dxyn() {
     uint8_t yPos = registers[Vy] % VIDEO_HEIGHT;
 
     registers[0xF] = 0;                     // Set VF to 0, as currently there are no collisions
+    // One video page per row drawn on. Pixels past the right edge aren't wrapped, they spill into the start of the next row, so mark that one too
+    unsigned int dirtyRows = rows + (xPos > VIDEO_WIDTH - 8 ? 1u : 0u);
+    dirtyPages |= (((1ull << dirtyRows) - 1) << (MEMORY_PAGE_COUNT + yPos)) & ALL_PAGES_DIRTY;
 
     /*
     NOTE: How this all crazy shit works...
@@ -480,6 +677,7 @@ void Chip8::OP_Fx0A() {
 	else
 	{
 		pc -= 2;                                // Decreent the PC to stop the next instruction from execiting (emulate a "wait" for a keypress)
+		if (metrics) {metrics->keyWaitCycles.fetch_add(1, std::memory_order_relaxed);}  // Count the idle cycle
 	}
 }
 
@@ -533,6 +731,7 @@ void Chip8::OP_Fx33() {
         memory[index + place] = value % 10;     // Store the final digit of the number in memory
         value /= 10;                            // Divide the value by 10 to remove the final digit
     }
+    MemoryWritten(index, 3);
 }
 
 // Fx55 -> LD I Vx: Load registers V0 to Vx into memory starting at index location
@@ -541,6 +740,7 @@ void Chip8::OP_Fx55() {
     for (uint8_t i = 0; i<= Vx; ++i) {          // Iterate i from 0 to Vx
         memory[index + i] = registers[i];       // Store the contents of register at i in memory location index reg + 1
     }
+    MemoryWritten(index, Vx + 1);
 }
 
 // Fx66 -> Ld Vx I: Load index reg onwards into registers V0 to Vx
@@ -552,4 +752,66 @@ void Chip8::OP_Fx65() {
 }
 
 // NULL -> Used to handle incorrect opcodes
-void Chip8::OP_NULL() {}                        // Empty function to deal with any invalid opcode calls
\ No newline at end of file
+void Chip8::OP_NULL() {}                        // Empty function to deal with any invalid opcode calls
+
+/* ------------------------ FUSED OPCODES ------------------------ */
+/*
+NOTE: Each of these must leave the Chip8 exactly as two calls to Cycle() would, timers included.
+They call the normal OP_ functions directly, so the only thing saved is the fetch and table lookup for each instruction.
+None of the first instructions read the PC, so it is moved past both instructions straight away.
+tools/chip8_profile.cpp --verify checks them against Cycle().
+*/
+// 7xkk + 3xkk -> ADD Vx kk, then SE Vx kk (the end of a counting loop)
+void Chip8::FUSED_7xkk_3xkk(uint16_t first, uint16_t second) {
+    pc += 4;
+    opcode = first;
+    OP_7xkk();
+    TickTimers();
+    opcode = second;
+    OP_3xkk();
+    TickTimers();
+}
+
+// 7xkk + 4xkk -> ADD Vx kk, then SNE Vx kk (the same, with the loop's jump the other way round)
+void Chip8::FUSED_7xkk_4xkk(uint16_t first, uint16_t second) {
+    pc += 4;
+    opcode = first;
+    OP_7xkk();
+    TickTimers();
+    opcode = second;
+    OP_4xkk();
+    TickTimers();
+}
+
+// Fx07 + 3xkk -> LD Vx DT, then SE Vx kk (waiting for the delay timer)
+void Chip8::FUSED_Fx07_3xkk(uint16_t first, uint16_t second) {
+    pc += 4;
+    opcode = first;
+    OP_Fx07();
+    TickTimers();
+    opcode = second;
+    OP_3xkk();
+    TickTimers();
+}
+
+// 6xkk + 6xkk -> LD Vx kk, twice
+void Chip8::FUSED_6xkk_6xkk(uint16_t first, uint16_t second) {
+    pc += 4;
+    opcode = first;
+    OP_6xkk();
+    TickTimers();
+    opcode = second;
+    OP_6xkk();
+    TickTimers();
+}
+
+// 6xkk + 7xkk -> LD Vx kk, then ADD Vx kk
+void Chip8::FUSED_6xkk_7xkk(uint16_t first, uint16_t second) {
+    pc += 4;
+    opcode = first;
+    OP_6xkk();
+    TickTimers();
+    opcode = second;
+    OP_7xkk();
+    TickTimers();
+}
@@ -1,7 +1,23 @@
 #ifndef CHIP8_H
 #define CHIP8_H
+#include <cstddef>
 #include <cstdint>
-#include <random>
+#include <array>
+
+class Tracer;                               // See Tracer.h
+class Metrics;                              // See Metrics.h
+struct AotModule;                           // See Aot.h
+class Debugger;                             // See Debugger.h
+
+/*
+For forking (see Fork.h), memory and video are split into 256-byte pages: memory is pages 0 to 15 and each
+row of video (64 pixels x 4 bytes) is one page, 16 to 47. Chip8::dirtyPages has one bit per page.
+*/
+const unsigned int STATE_PAGE_SIZE = 256;
+const unsigned int MEMORY_PAGE_COUNT = 16;
+const unsigned int VIDEO_PAGE_COUNT = 32;
+const unsigned int STATE_PAGE_COUNT = MEMORY_PAGE_COUNT + VIDEO_PAGE_COUNT;
+const uint64_t ALL_PAGES_DIRTY = (1ull << STATE_PAGE_COUNT) - 1;
 
 class Chip8 {
     public:
@@ -16,25 +32,48 @@ class Chip8 {
         uint8_t soundTimer{};
         uint8_t keypad[16]{};               // Keypad keys 0 to F
         uint32_t video[64 * 32]{};          // 64x32 monochrome display (32-bit to help with SDL)
-        uint16_t opcode;                    // Opcode of instruction, not initialised
+        uint16_t opcode;                    // Opcode of the instruction being run (0 after Reset)
+        uint32_t randState{};               // State of the xorshift RNG used by Cxkk (never 0 once seeded)
+        Tracer* tracer{};                   // Instruction trace buffer, nullptr when tracing is off (can be swapped at any time)
+        Metrics* metrics{};                 // Telemetry counters, nullptr when nobody is collecting them
+        AotModule const* aot{};             // Natively compiled code for the loaded ROM, nullptr to just interpret
+        uint64_t romHash{};                 // Fnv1a of the loaded ROM (0 if none), finds its compiled code again after a savestate load
+        Debugger* debugger{};               // Attached debugger (e.g. GdbStub), nullptr when not debugging
+        uint64_t dirtyPages{};              // Pages of memory/video written since the last Fork or Restore (write memory from outside through WriteMemory(), which sets them)
 
         // Methods
-        Chip8();                            // Constructor
-        void LoadROM(char const* filename); // Method to load a ROM file
-        void Cycle();                       // FDE Cycle func
+        explicit Chip8(uint32_t seed = 1);  // Constructor, seed is for the RNG (main.cpp passes the clock)
+        void Reset(uint32_t seed = 1);      // Put the machine back to power-on state without reallocating it (detaches tracer, metrics and debugger too)
+        bool LoadROM(char const* filename); // Method to load a ROM file (false if it can't be read or doesn't fit)
+        bool LoadROM(uint8_t const* data, size_t size);  // Same as above but from a buffer
+        void Cycle();                       // FDE Cycle func (doesn't check breakpoints, only Run() does)
+        void Run(uint32_t cycles);          // Run several FDE cycles in a row (using compiled code where there is some, and stopping at breakpoints)
+        void Execute(uint16_t op);          // Decode and execute one opcode, PC must already point past it
+        bool WriteMemory(uint16_t address, uint8_t const* data, size_t count);  // Write memory from outside, as Fx55 would (false if it doesn't fit)
+        void SetFusion(bool on);            // Let Run() execute common pairs of instructions as one (see the FUSED handlers)
+        bool Fusion() const;                // Whether fusion is on
+        void DecodeFusedPairs(int from = 0, int to = 4095);  // Redo fusedStarts for addresses from to to (after memory is replaced, only needed with fusion on)
 
     private:
         // Attributes
-        std::default_random_engine randGen;                 // Engine to generate a random number
-        std::uniform_int_distribution<uint8_t> randByte;    // Used to store a byte of random data
+        bool fusion{};                      // Set through SetFusion(), which finds the pairs that are already in memory
+        uint64_t fusedStarts[4096 / 64]{};  // Bit n is set if a fused pair starts at address n, kept up to date while fusion is on
+
+        // Methods
+        uint8_t RandByte();                 // Step the RNG and return one byte of random data
+        void CheckCodeWrite(uint16_t address, unsigned int count);  // Stop using compiled code if memory it was compiled from is written
+        void TickTimers();                  // Count the delay and sound timers down by one
+        void MarkMemoryDirty(uint16_t address, unsigned int count);  // Record a memory write in dirtyPages
+        void MemoryWritten(uint16_t address, unsigned int count);  // Bookkeeping after any memory write (dirtyPages, fusedStarts, aot, debugger)
 
         // Define function pointer table
+        // The tables are static so every Chip8 shares one copy, they are filled in at compile time in Chip8.cpp
         typedef void (Chip8::*Chip8Func)(); // Declares Chip8Func as a pointer to a void function with no params
-        Chip8Func table[0xF + 1];           // First dimension of the table, for all the first chars of opcodes
-        Chip8Func table0[0xE + 1];          // Dimension of array for opcodes starting 0
-    	Chip8Func table8[0xE + 1];          // Dimension of array for opcodes starting 8
-	    Chip8Func tableE[0xE + 1];          // Dimension of array for opcodes starting E
-	    Chip8Func tableF[0x65 + 1];         // Dimension of array for opcodes starting F
+        static const std::array<Chip8Func, 0xF + 1> table;   // First dimension of the table, for all the first chars of opcodes
+        static const std::array<Chip8Func, 0xE + 1> table0;  // Dimension of array for opcodes starting 0
+        static const std::array<Chip8Func, 0xE + 1> table8;  // Dimension of array for opcodes starting 8
+        static const std::array<Chip8Func, 0xE + 1> tableE;  // Dimension of array for opcodes starting E
+        static const std::array<Chip8Func, 0x65 + 1> tableF; // Dimension of array for opcodes starting F
 
         // Define functions for the other dimensions of the function pointer table (not confusing at all)
         void Table0();                      // Function which figures out which opcode starting 0 is being referred to
@@ -43,6 +82,16 @@ class Chip8 {
         void TableF();                      // Same as above, but for opcodes starting F
         void OP_NULL();                     // Deals with any situation where the opcode is not recognised
 
+        // Fused handlers: run two instructions in a row as one. Run() only calls them where fusedStarts says the pair is
+        // The table is indexed by the first nibble of both opcodes, e.g. [0x73] for a 7xkk followed by a 3xkk
+        typedef void (Chip8::*Chip8Fused)(uint16_t first, uint16_t second);
+        static const std::array<Chip8Fused, 0xFF + 1> fusedTable;
+        void FUSED_7xkk_3xkk(uint16_t first, uint16_t second);  // Count, then leave the loop at the end value
+        void FUSED_7xkk_4xkk(uint16_t first, uint16_t second);  // Count, then carry on looping until the end value
+        void FUSED_Fx07_3xkk(uint16_t first, uint16_t second);  // Read the delay timer, then stop waiting once it is 0
+        void FUSED_6xkk_6xkk(uint16_t first, uint16_t second);  // Two loads, e.g. setting up coordinates
+        void FUSED_6xkk_7xkk(uint16_t first, uint16_t second);  // Reset a counter, then start counting
+
         // Opcodes
         void OP_00E0();                     // OPCODE 00E0 -> CLS: Clears the display
         void OP_00EE();                     // OPCODE 00EE -> RET: Return from a subroutine
@@ -0,0 +1,46 @@
+#include "Chip8Pool.h"
+#include <cassert>
+
+/* ------------------------- CONSTRUCTOR ------------------------- */
+Chip8Pool::Chip8Pool(size_t capacity)
+: instances(capacity), inUse(capacity, 0)
+{
+    freeList.reserve(capacity);
+    for (size_t i = capacity; i > 0; --i) {     // Push in reverse so instance 0 is handed out first
+        freeList.push_back(static_cast<uint32_t>(i - 1));
+    }
+}
+
+/* ------------------------ POOL FUNCTIONS ----------------------- */
+// Pop a free instance off the stack and reset it, this is the only real cost of "creating" a Chip8
+Chip8* Chip8Pool::Acquire(uint32_t seed) {
+    if (freeList.empty()) {return nullptr;}     // Every instance is in use
+    Chip8* chip8 = &instances[freeList.back()];
+    inUse[freeList.back()] = 1;
+    freeList.pop_back();
+    chip8->Reset(seed);
+    return chip8;
+}
+
+// Push the instance's index back onto the free stack (the reset happens next time it is acquired)
+// A pointer from elsewhere or a second release would put an instance on the stack twice, and then hand it to two owners
+bool Chip8Pool::Release(Chip8* chip8) {
+    if (chip8 == nullptr) {return false;}
+    bool ours = chip8 >= instances.data() && chip8 < instances.data() + instances.size();
+    assert(ours && "Chip8 released to a pool it didn't come from");
+    if (!ours) {return false;}
+    uint32_t index = static_cast<uint32_t>(chip8 - instances.data());
+    assert(inUse[index] && "Chip8 released twice");
+    if (!inUse[index]) {return false;}
+    inUse[index] = 0;
+    freeList.push_back(index);
+    return true;
+}
+
+size_t Chip8Pool::Capacity() const {
+    return instances.size();
+}
+
+size_t Chip8Pool::Available() const {
+    return freeList.size();
+}
@@ -0,0 +1,25 @@
+#ifndef CHIP8POOL_H
+#define CHIP8POOL_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Chip8.h"
+
+// A fixed-size pool of Chip8 instances, so handing one out or taking it back never touches the heap
+class Chip8Pool {
+    public:
+        // Methods
+        explicit Chip8Pool(size_t capacity);    // Allocates every instance up front, in one contiguous block
+        Chip8* Acquire(uint32_t seed = 1);      // Resets a free instance and hands it out (nullptr if the pool is empty)
+        bool Release(Chip8* chip8);             // Gives an instance back to the pool so it can be reused (false if it isn't one of ours, or is already back)
+        size_t Capacity() const;                // Total number of instances in the pool
+        size_t Available() const;               // Number of instances not currently handed out
+
+    private:
+        // Attributes
+        std::vector<Chip8> instances;           // The instances themselves
+        std::vector<uint32_t> freeList;         // Indexes of instances that are free, used as a stack
+        std::vector<uint8_t> inUse;             // 1 for each instance currently handed out, catches double releases
+};
+
+#endif
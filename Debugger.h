@@ -0,0 +1,35 @@
+#ifndef DEBUGGER_H
+#define DEBUGGER_H
+#include <cstdint>
+
+class Chip8;
+
+/*
+What the core calls into when a debugger is attached (Chip8::debugger), see GdbStub.h for the real one.
+Breakpoints are kept here as one bit per address rather than written into memory, so the ROM, savestates
+and forks only ever see the real bytes. Chip8::Run() only looks at them while a debugger is attached, so
+with no debugger the interpreter runs exactly as it always has. A bare Chip8::Cycle() never looks at them:
+anything that should stop at breakpoints (main.cpp, chip8_step, chip8_step_many) has to go through Run().
+*/
+class Debugger {
+    public:
+        virtual ~Debugger() = default;
+
+        // Whether Chip8::Run() has to stop before running the instruction at address
+        bool IsTrap(uint16_t address) const {
+            return stepping || ((trapBits[(address & 0x0FFFu) >> 6u] >> (address & 63u)) & 1u);
+        }
+
+        // Called with chip8.pc at a trap, before the instruction there is fetched. Returns once the debugger resumes,
+        // and the instruction at chip8.pc (which the debugger may have moved) then runs as normal
+        virtual void Break(Chip8& chip8) = 0;
+
+        // Called after an instruction writes memory (Fx33 and Fx55), for watchpoints
+        virtual void MemoryWritten(Chip8& chip8, uint16_t address, unsigned int count) = 0;
+
+    protected:
+        uint64_t trapBits[4096 / 64]{};         // Bit n is set if there is a breakpoint at address n
+        bool stepping = false;                  // Stop again before the next instruction, wherever it is
+};
+
+#endif
@@ -0,0 +1,180 @@
+#include "Fork.h"
+#include <cstring>
+#include "Hash.h"
+
+static_assert(sizeof(Chip8::memory) == MEMORY_PAGE_COUNT * STATE_PAGE_SIZE, "Memory must split evenly into pages");
+static_assert(sizeof(Chip8::video) == VIDEO_PAGE_COUNT * STATE_PAGE_SIZE, "Video must split evenly into pages");
+
+// Where page number page lives inside a Chip8
+static uint8_t* PageData(Chip8& chip8, unsigned int page) {
+    if (page < MEMORY_PAGE_COUNT) {return &chip8.memory[page * STATE_PAGE_SIZE];}
+    return reinterpret_cast<uint8_t*>(chip8.video) + (page - MEMORY_PAGE_COUNT) * STATE_PAGE_SIZE;
+}
+
+/* ------------------------ FORK FUNCTIONS ----------------------- */
+StateId ForkStore::Fork(Chip8& chip8, StateId base) {
+    State state;
+    for (unsigned int page = 0; page < STATE_PAGE_COUNT; ++page) {
+        if (base != NO_STATE && !(chip8.dirtyPages & (1ull << page))) {
+            state.pages[page] = states[base].pages[page];   // Untouched since base, so share its page
+            ++pages[state.pages[page]].refs;
+        } else {
+            state.pages[page] = InternPage(PageData(chip8, page));
+        }
+    }
+    chip8.dirtyPages = 0;                       // chip8 now matches the state being returned
+
+    memcpy(state.registers, chip8.registers, sizeof(state.registers));
+    memcpy(state.keypad, chip8.keypad, sizeof(state.keypad));
+    memcpy(state.stack, chip8.stack, sizeof(state.stack));
+    state.index = chip8.index;
+    state.pc = chip8.pc;
+    state.opcode = chip8.opcode;
+    state.sp = chip8.sp;
+    state.delayTimer = chip8.delayTimer;
+    state.soundTimer = chip8.soundTimer;
+    state.randState = chip8.randState;
+    state.aot = chip8.aot;
+    state.romHash = chip8.romHash;
+    state.refs = 1;
+
+    // Hash field by field rather than the whole struct, so padding never gets into it
+    uint64_t hash = Fnv1a(state.pages, sizeof(state.pages));    // Page ids stand in for the pages, equal ids mean equal content
+    hash = Fnv1a(state.registers, sizeof(state.registers), hash);
+    hash = Fnv1a(state.keypad, sizeof(state.keypad), hash);
+    hash = Fnv1a(state.stack, sizeof(state.stack), hash);
+    hash = Fnv1a(&state.index, sizeof(state.index), hash);
+    hash = Fnv1a(&state.pc, sizeof(state.pc), hash);
+    hash = Fnv1a(&state.opcode, sizeof(state.opcode), hash);
+    hash = Fnv1a(&state.sp, sizeof(state.sp), hash);
+    hash = Fnv1a(&state.delayTimer, sizeof(state.delayTimer), hash);
+    hash = Fnv1a(&state.soundTimer, sizeof(state.soundTimer), hash);
+    hash = Fnv1a(&state.randState, sizeof(state.randState), hash);
+    state.hash = hash;
+
+    // Hand back the existing copy if this exact state is already stored
+    auto range = stateIndex.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        State& existing = states[it->second];
+        if (SameState(existing, state)) {
+            for (uint32_t page : state.pages) {ReleasePage(page);}  // The existing state already holds these pages
+            ++existing.refs;
+            return it->second;
+        }
+    }
+
+    StateId id;
+    if (!freeStates.empty()) {
+        id = freeStates.back();
+        freeStates.pop_back();
+        states[id] = state;
+    } else {
+        id = static_cast<StateId>(states.size());
+        states.push_back(state);
+    }
+    stateIndex.emplace(hash, id);
+    return id;
+}
+
+// Only pages that differ from what chip8 already holds (or that it has written since) are copied
+void ForkStore::Restore(StateId id, Chip8& chip8, StateId current) {
+    State const& state = states[id];
+    for (unsigned int page = 0; page < STATE_PAGE_COUNT; ++page) {
+        if (current != NO_STATE && states[current].pages[page] == state.pages[page] && !(chip8.dirtyPages & (1ull << page))) {
+            continue;
+        }
+        memcpy(PageData(chip8, page), pages[state.pages[page]].data, STATE_PAGE_SIZE);
+        if (page < MEMORY_PAGE_COUNT && chip8.Fusion()) {chip8.DecodeFusedPairs(page * STATE_PAGE_SIZE - 3, page * STATE_PAGE_SIZE + STATE_PAGE_SIZE - 1);}
+    }
+    chip8.dirtyPages = 0;
+
+    memcpy(chip8.registers, state.registers, sizeof(state.registers));
+    memcpy(chip8.keypad, state.keypad, sizeof(state.keypad));
+    memcpy(chip8.stack, state.stack, sizeof(state.stack));
+    chip8.index = state.index;
+    chip8.pc = state.pc;
+    chip8.opcode = state.opcode;
+    chip8.sp = state.sp;
+    chip8.delayTimer = state.delayTimer;
+    chip8.soundTimer = state.soundTimer;
+    chip8.randState = state.randState;
+    chip8.aot = state.aot;
+    chip8.romHash = state.romHash;
+}
+
+void ForkStore::Release(StateId id) {
+    State& state = states[id];
+    if (--state.refs > 0) {return;}
+
+    for (uint32_t page : state.pages) {ReleasePage(page);}
+    auto range = stateIndex.equal_range(state.hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == id) {
+            stateIndex.erase(it);
+            break;
+        }
+    }
+    freeStates.push_back(id);
+}
+
+uint64_t ForkStore::Hash(StateId id) const {
+    return states[id].hash;
+}
+
+size_t ForkStore::StateCount() const {
+    return states.size() - freeStates.size();
+}
+
+size_t ForkStore::PageCount() const {
+    return pages.size() - freePages.size();
+}
+
+/* ------------------------ PAGE FUNCTIONS ----------------------- */
+uint32_t ForkStore::InternPage(uint8_t const* data) {
+    uint64_t hash = Fnv1a(data, STATE_PAGE_SIZE);
+    auto range = pageIndex.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (memcmp(pages[it->second].data, data, STATE_PAGE_SIZE) == 0) {   // Hashes can collide, so check the bytes too
+            ++pages[it->second].refs;
+            return it->second;
+        }
+    }
+
+    uint32_t id;
+    if (!freePages.empty()) {
+        id = freePages.back();
+        freePages.pop_back();
+    } else {
+        id = static_cast<uint32_t>(pages.size());
+        pages.emplace_back();
+    }
+    memcpy(pages[id].data, data, STATE_PAGE_SIZE);
+    pages[id].hash = hash;
+    pages[id].refs = 1;
+    pageIndex.emplace(hash, id);
+    return id;
+}
+
+void ForkStore::ReleasePage(uint32_t id) {
+    Page& page = pages[id];
+    if (--page.refs > 0) {return;}
+
+    auto range = pageIndex.equal_range(page.hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == id) {
+            pageIndex.erase(it);
+            break;
+        }
+    }
+    freePages.push_back(id);
+}
+
+bool ForkStore::SameState(State const& a, State const& b) {
+    return memcmp(a.pages, b.pages, sizeof(a.pages)) == 0 &&
+           memcmp(a.registers, b.registers, sizeof(a.registers)) == 0 &&
+           memcmp(a.keypad, b.keypad, sizeof(a.keypad)) == 0 &&
+           memcmp(a.stack, b.stack, sizeof(a.stack)) == 0 &&
+           a.index == b.index && a.pc == b.pc && a.opcode == b.opcode && a.sp == b.sp &&
+           a.delayTimer == b.delayTimer && a.soundTimer == b.soundTimer &&
+           a.randState == b.randState && a.aot == b.aot && a.romHash == b.romHash;
+}
@@ -0,0 +1,72 @@
+#ifndef FORK_H
+#define FORK_H
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "Chip8.h"
+
+typedef uint32_t StateId;
+const StateId NO_STATE = 0xFFFFFFFFu;           // "No state", e.g. when there is no parent to share pages with
+
+/*
+Stores many snapshots of a Chip8 cheaply, for bots that search a tree of inputs. Memory and video are cut
+into the 256-byte pages described in Chip8.h and every page is stored once, no matter how many states use
+it, so forking a state only has to copy the pages written since it was restored (Chip8::dirtyPages).
+States that come out exactly the same (e.g. two keys the ROM ignores) are also stored once, and Fork
+returns the same id for both.
+
+Typical use: Fork the root, then for each branch Restore it, press a key, Run, and Fork the result with the
+state it was restored from as the base. Not thread safe, give each search thread its own store.
+*/
+class ForkStore {
+    public:
+        // Methods
+        StateId Fork(Chip8& chip8, StateId base = NO_STATE);  // Snapshot chip8 (which must have been restored from or forked as base, if one is given)
+        void Restore(StateId id, Chip8& chip8, StateId current = NO_STATE);  // Load a state into chip8 (current is the state it already holds, if known)
+        void Release(StateId id);               // Drop one reference taken by Fork, the state is freed when the last one goes
+        uint64_t Hash(StateId id) const;        // Hash of the whole state, equal states have equal hashes
+        size_t StateCount() const;              // States currently stored
+        size_t PageCount() const;               // Distinct pages currently stored
+
+    private:
+        struct Page {
+            uint8_t data[STATE_PAGE_SIZE];
+            uint64_t hash;
+            uint32_t refs;                      // 0 means the slot is free
+        };
+
+        // Everything in a Chip8 that is not in a page (tracer, metrics, fusion are settings, not state, so are left alone)
+        struct State {
+            uint32_t pages[STATE_PAGE_COUNT];   // Page ids, memory pages first then video rows
+            uint8_t registers[16];
+            uint8_t keypad[16];
+            uint16_t stack[16];
+            uint16_t index;
+            uint16_t pc;
+            uint16_t opcode;
+            uint8_t sp;
+            uint8_t delayTimer;
+            uint8_t soundTimer;
+            uint32_t randState;
+            AotModule const* aot;
+            uint64_t romHash;
+            uint64_t hash;
+            uint32_t refs;                      // 0 means the slot is free
+        };
+
+        // Attributes
+        std::vector<Page> pages;
+        std::vector<State> states;
+        std::vector<uint32_t> freePages;        // Free slots in pages, used as a stack
+        std::vector<StateId> freeStates;        // Free slots in states, used as a stack
+        std::unordered_multimap<uint64_t, uint32_t> pageIndex;   // Page hash -> page id
+        std::unordered_multimap<uint64_t, StateId> stateIndex;   // State hash -> state id
+
+        // Methods
+        uint32_t InternPage(uint8_t const* data);   // Id of a page with this content, adding it if it is new
+        void ReleasePage(uint32_t id);
+        static bool SameState(State const& a, State const& b);
+};
+
+#endif
@@ -0,0 +1,415 @@
+#include "GdbStub.h"
+#include "Aot.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string.h>     // To use memset
+#include <unistd.h>     // close
+#include <netinet/in.h> // sockaddr_in
+#include <netinet/tcp.h>    // TCP_NODELAY
+#include <arpa/inet.h>  // htons and htonl
+#include <sys/socket.h>
+
+const uint8_t TRAP_USER = 1;                    // A breakpoint the debugger set
+const uint8_t TRAP_TEMPORARY = 2;               // Where to stop next after a step, Ctrl-C or watchpoint, cleared at every stop
+const uint16_t MEMORY_SIZE = sizeof(Chip8::memory);
+const unsigned int REGISTER_COUNT = 37;         // See the table in GdbStub.h
+
+// Register layout for debuggers that ask for one (qXfer:features:read)
+static char const TARGET_XML[] =
+    "<?xml version=\"1.0\"?><!DOCTYPE target SYSTEM \"gdb-target.dtd\"><target><feature name=\"org.chip8.core\">"
+    "<reg name=\"v0\" bitsize=\"8\"/><reg name=\"v1\" bitsize=\"8\"/><reg name=\"v2\" bitsize=\"8\"/><reg name=\"v3\" bitsize=\"8\"/>"
+    "<reg name=\"v4\" bitsize=\"8\"/><reg name=\"v5\" bitsize=\"8\"/><reg name=\"v6\" bitsize=\"8\"/><reg name=\"v7\" bitsize=\"8\"/>"
+    "<reg name=\"v8\" bitsize=\"8\"/><reg name=\"v9\" bitsize=\"8\"/><reg name=\"va\" bitsize=\"8\"/><reg name=\"vb\" bitsize=\"8\"/>"
+    "<reg name=\"vc\" bitsize=\"8\"/><reg name=\"vd\" bitsize=\"8\"/><reg name=\"ve\" bitsize=\"8\"/><reg name=\"vf\" bitsize=\"8\"/>"
+    "<reg name=\"i\" bitsize=\"16\"/><reg name=\"pc\" bitsize=\"16\" type=\"code_ptr\"/><reg name=\"sp\" bitsize=\"8\"/>"
+    "<reg name=\"dt\" bitsize=\"8\"/><reg name=\"st\" bitsize=\"8\"/>"
+    "<reg name=\"s0\" bitsize=\"16\"/><reg name=\"s1\" bitsize=\"16\"/><reg name=\"s2\" bitsize=\"16\"/><reg name=\"s3\" bitsize=\"16\"/>"
+    "<reg name=\"s4\" bitsize=\"16\"/><reg name=\"s5\" bitsize=\"16\"/><reg name=\"s6\" bitsize=\"16\"/><reg name=\"s7\" bitsize=\"16\"/>"
+    "<reg name=\"s8\" bitsize=\"16\"/><reg name=\"s9\" bitsize=\"16\"/><reg name=\"s10\" bitsize=\"16\"/><reg name=\"s11\" bitsize=\"16\"/>"
+    "<reg name=\"s12\" bitsize=\"16\"/><reg name=\"s13\" bitsize=\"16\"/><reg name=\"s14\" bitsize=\"16\"/><reg name=\"s15\" bitsize=\"16\"/>"
+    "</feature></target>";
+
+static char const TARGET_XML_READ[] = "qXfer:features:read:target.xml:";
+
+/* --------------------------- HELPERS --------------------------- */
+static std::string ToHex(uint8_t const* bytes, size_t size) {
+    static char const digits[] = "0123456789abcdef";
+    std::string hex;
+    for (size_t i = 0; i < size; ++i) {
+        hex += digits[bytes[i] >> 4u];
+        hex += digits[bytes[i] & 0x0Fu];
+    }
+    return hex;
+}
+
+static std::vector<uint8_t> FromHex(std::string const& hex) {
+    std::vector<uint8_t> bytes;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        bytes.push_back(static_cast<uint8_t>(strtoul(hex.substr(i, 2).c_str(), nullptr, 16)));
+    }
+    return bytes;
+}
+
+// Offset and size in bytes of register number in the g packet
+static bool RegisterSlot(unsigned int number, size_t& offset, size_t& size) {
+    if (number < 16) {offset = number; size = 1;}
+    else if (number == 16) {offset = 16; size = 2;}
+    else if (number == 17) {offset = 18; size = 2;}
+    else if (number < 21) {offset = 20 + (number - 18); size = 1;}
+    else if (number < REGISTER_COUNT) {offset = 23 + (number - 21) * 2; size = 2;}
+    else {return false;}
+    return true;
+}
+
+/* -------------------------- CONNECTION ------------------------- */
+GdbStub::~GdbStub() {
+    if (clientFd >= 0) {close(clientFd);}
+    if (listenFd >= 0) {close(listenFd);}
+}
+
+// Localhost only, the protocol has no authentication
+bool GdbStub::Listen(uint16_t port) {
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) {return false;}
+    int enable = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listenFd, 1) < 0) {
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    return true;
+}
+
+bool GdbStub::Accept() {
+    clientFd = accept(listenFd, nullptr, nullptr);
+    if (clientFd < 0) {return false;}
+    int enable = 1;
+    setsockopt(clientFd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));  // Packets are tiny and every one waits for an answer
+    return true;
+}
+
+void GdbStub::Attach(Chip8& chip8) {
+    chip8.debugger = this;
+    AddTrap(chip8.pc, TRAP_TEMPORARY);   // Stop before the next instruction, and wait there for the debugger's first packet
+}
+
+void GdbStub::Poll(Chip8& chip8) {
+    if (clientFd < 0) {return;}
+    uint8_t byte;
+    ssize_t received = recv(clientFd, &byte, 1, MSG_DONTWAIT);
+    if (received == 0) {                        // Connection closed
+        Detach(chip8);
+    } else if (received == 1 && byte == 0x03) { // Ctrl-C
+        stopSignal = 2;
+        AddTrap(chip8.pc, TRAP_TEMPORARY);
+    }
+}
+
+bool GdbStub::Killed() const {
+    return killed;
+}
+
+// Drop every trap and let the program run on its own
+void GdbStub::Detach(Chip8& chip8) {
+    traps.clear();
+    UpdateTrapBits();
+    watchpoints.clear();
+    stepping = false;
+    chip8.debugger = nullptr;
+    chip8.aot = FindAotModule(chip8.romHash, chip8.memory);    // Compiled code wasn't used while debugging, and memory may have been edited since
+    if (clientFd >= 0) {
+        close(clientFd);
+        clientFd = -1;
+    }
+}
+
+/* ------------------------- CORE HOOKS -------------------------- */
+void GdbStub::Break(Chip8& chip8) {
+    // Temporary traps (and a step) have done their job once anything stops the program
+    for (auto it = traps.begin(); it != traps.end();) {
+        it->second &= ~TRAP_TEMPORARY;
+        it = it->second ? std::next(it) : traps.erase(it);
+    }
+    UpdateTrapBits();
+    stepping = false;
+
+    if (resumed) {
+        resumed = false;
+        if (!WritePacket(StopReply())) {Detach(chip8);}
+    }
+    while (clientFd >= 0) {                     // Serve the debugger until it says to carry on
+        std::string packet;
+        if (!ReadPacket(packet)) {
+            Detach(chip8);
+            break;
+        }
+        if (HandlePacket(chip8, packet)) {break;}  // The instruction at pc (which the debugger may have moved) runs next
+    }
+}
+
+void GdbStub::MemoryWritten(Chip8& chip8, uint16_t address, unsigned int count) {
+    for (auto const& watchpoint : watchpoints) {
+        if (address < watchpoint.address + watchpoint.length && watchpoint.address < address + count) {
+            stopSignal = 5;
+            watchAddress = address > watchpoint.address ? address : watchpoint.address;
+            AddTrap(chip8.pc, TRAP_TEMPORARY);   // Stop right after the instruction that wrote it
+            return;
+        }
+    }
+}
+
+/* --------------------------- PACKETS --------------------------- */
+bool GdbStub::HandlePacket(Chip8& chip8, std::string const& packet) {
+    char command = packet.empty() ? '\0' : packet[0];
+    std::string arguments = packet.empty() ? "" : packet.substr(1);
+    std::string reply;
+
+    switch (command) {
+        case '?':
+            reply = StopReply();
+            break;
+        case 'g': {
+            std::vector<uint8_t> registers = ReadRegisters(chip8);
+            reply = ToHex(registers.data(), registers.size());
+            break;
+        }
+        case 'G':
+            WriteRegisters(chip8, FromHex(arguments));
+            reply = "OK";
+            break;
+        case 'p': {
+            size_t offset, size;
+            if (!RegisterSlot(strtoul(arguments.c_str(), nullptr, 16), offset, size)) {reply = "E01"; break;}
+            std::vector<uint8_t> registers = ReadRegisters(chip8);
+            reply = ToHex(&registers[offset], size);
+            break;
+        }
+        case 'P': {
+            size_t offset, size;
+            size_t equals = arguments.find('=');
+            if (equals == std::string::npos || !RegisterSlot(strtoul(arguments.c_str(), nullptr, 16), offset, size)) {reply = "E01"; break;}
+            std::vector<uint8_t> registers = ReadRegisters(chip8);
+            std::vector<uint8_t> value = FromHex(arguments.substr(equals + 1));
+            for (size_t i = 0; i < size && i < value.size(); ++i) {registers[offset + i] = value[i];}
+            WriteRegisters(chip8, registers);
+            reply = "OK";
+            break;
+        }
+        case 'm': {                             // m<address>,<length>
+            char* end;
+            unsigned long address = strtoul(arguments.c_str(), &end, 16);
+            if (*end != ',') {reply = "E01"; break;}
+            unsigned long length = strtoul(end + 1, nullptr, 16);
+            if (address >= MEMORY_SIZE) {reply = "E01"; break;}
+            std::vector<uint8_t> bytes;
+            for (unsigned long i = address; i < address + length && i < MEMORY_SIZE; ++i) {bytes.push_back(chip8.memory[i]);}
+            reply = ToHex(bytes.data(), bytes.size());
+            break;
+        }
+        case 'M': {                             // M<address>,<length>:<hex bytes>
+            char* end;
+            unsigned long address = strtoul(arguments.c_str(), &end, 16);
+            size_t colon = arguments.find(':');
+            std::vector<uint8_t> bytes = FromHex(colon == std::string::npos ? "" : arguments.substr(colon + 1));
+            if (address + bytes.size() > MEMORY_SIZE) {reply = "E01"; break;}
+            for (size_t i = 0; i < bytes.size(); ++i) {WriteByte(chip8, address + i, bytes[i]);}
+            reply = "OK";
+            break;
+        }
+        case 'c':                               // c[address] and s[address], the address is where to carry on from
+        case 's':
+            if (!arguments.empty()) {chip8.pc = strtoul(arguments.c_str(), nullptr, 16) & 0x0FFFu;}
+            stepping = command == 's';
+            stopSignal = 5;
+            watchAddress = -1;
+            resumed = true;
+            return true;
+        case 'Z':                               // Z<type>,<address>,<kind> and z<type>,<address>,<kind>
+        case 'z': {
+            char* end;
+            unsigned long type = strtoul(arguments.c_str(), &end, 16);
+            if (*end != ',') {reply = "E01"; break;}
+            unsigned long address = strtoul(end + 1, &end, 16);
+            if (*end != ',') {reply = "E01"; break;}
+            unsigned long kind = strtoul(end + 1, nullptr, 16);
+            if (type == 0 || type == 1) {      // Software and hardware breakpoints are the same thing here
+                if (command == 'z') {
+                    RemoveTrap(address, TRAP_USER);
+                    reply = "OK";
+                } else {
+                    reply = AddTrap(address, TRAP_USER) ? "OK" : "E01";
+                }
+            } else if (type == 2) {            // Write watchpoints only, nothing sees memory reads
+                if (command == 'Z') {
+                    watchpoints.push_back({static_cast<uint16_t>(address), static_cast<uint16_t>(kind ? kind : 1)});
+                } else {
+                    for (auto it = watchpoints.begin(); it != watchpoints.end(); ++it) {
+                        if (it->address == address) {
+                            watchpoints.erase(it);
+                            break;
+                        }
+                    }
+                }
+                reply = "OK";
+            }
+            break;
+        }
+        case 'D':
+            WritePacket("OK");
+            Detach(chip8);
+            return true;
+        case 'k':                               // No reply to a kill
+            killed = true;
+            Detach(chip8);
+            return true;
+        case 'H':                               // One thread, so any thread selection is fine
+        case 'T':
+            reply = "OK";
+            break;
+        case 'q':
+            if (packet.compare(0, 10, "qSupported") == 0) {
+                reply = "PacketSize=1000;qXfer:features:read+";
+            } else if (packet == "qAttached") {
+                reply = "1";
+            } else if (packet == "qC") {
+                reply = "QC1";
+            } else if (packet == "qfThreadInfo") {
+                reply = "m1";
+            } else if (packet == "qsThreadInfo") {
+                reply = "l";
+            } else if (packet.compare(0, sizeof(TARGET_XML_READ) - 1, TARGET_XML_READ) == 0) {
+                // qXfer:features:read:target.xml:<offset>,<length>
+                char* end;
+                size_t offset = strtoul(packet.c_str() + sizeof(TARGET_XML_READ) - 1, &end, 16);
+                size_t length = strtoul(end + 1, nullptr, 16);
+                std::string xml = TARGET_XML;
+                if (offset >= xml.size()) {reply = "l"; break;}
+                std::string chunk = xml.substr(offset, length);
+                reply = (offset + chunk.size() < xml.size() ? "m" : "l") + chunk;
+            }
+            break;
+        default:                                // An empty reply tells the debugger the packet isn't supported
+            break;
+    }
+    if (!WritePacket(reply)) {Detach(chip8);}
+    return clientFd < 0;                        // Lost the debugger, so carry on running
+}
+
+// Packets look like $<data>#<two hex digit checksum>, and are acknowledged with + (or - to ask for them again)
+bool GdbStub::ReadPacket(std::string& packet) {
+    while (true) {
+        uint8_t byte;
+        do {                                    // Skip acks and Ctrl-C (already stopped) until a packet starts
+            if (recv(clientFd, &byte, 1, 0) != 1) {return false;}
+        } while (byte != '$');
+
+        packet.clear();
+        uint8_t sum = 0;
+        while (true) {
+            if (recv(clientFd, &byte, 1, 0) != 1) {return false;}
+            if (byte == '#') {break;}
+            packet += static_cast<char>(byte);
+            sum += byte;
+        }
+        char checksum[3] = {};
+        if (recv(clientFd, checksum, 2, MSG_WAITALL) != 2) {return false;}
+
+        bool valid = strtoul(checksum, nullptr, 16) == sum;
+        if (send(clientFd, valid ? "+" : "-", 1, MSG_NOSIGNAL) != 1) {return false;}
+        if (valid) {return true;}
+    }
+}
+
+bool GdbStub::WritePacket(std::string const& data) {
+    uint8_t sum = 0;
+    for (char c : data) {sum += static_cast<uint8_t>(c);}
+    char checksum[4];
+    snprintf(checksum, sizeof(checksum), "#%02x", sum);
+    std::string packet = "$" + data + checksum;
+
+    while (true) {
+        if (send(clientFd, packet.data(), packet.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(packet.size())) {return false;}
+        uint8_t ack;
+        do {
+            if (recv(clientFd, &ack, 1, 0) != 1) {return false;}
+        } while (ack != '+' && ack != '-');
+        if (ack == '+') {return true;}          // Otherwise it was garbled on the way, send it again
+    }
+}
+
+std::string GdbStub::StopReply() const {
+    char reply[32];
+    if (watchAddress >= 0) {
+        snprintf(reply, sizeof(reply), "T%02xwatch:%x;", stopSignal, watchAddress);
+    } else {
+        snprintf(reply, sizeof(reply), "S%02x", stopSignal);
+    }
+    return reply;
+}
+
+/* -------------------------- REGISTERS -------------------------- */
+std::vector<uint8_t> GdbStub::ReadRegisters(Chip8 const& chip8) const {
+    std::vector<uint8_t> bytes(chip8.registers, chip8.registers + 16);
+    bytes.push_back(chip8.index & 0xFFu);
+    bytes.push_back(chip8.index >> 8u);
+    bytes.push_back(chip8.pc & 0xFFu);
+    bytes.push_back(chip8.pc >> 8u);
+    bytes.push_back(chip8.sp);
+    bytes.push_back(chip8.delayTimer);
+    bytes.push_back(chip8.soundTimer);
+    for (uint16_t entry : chip8.stack) {
+        bytes.push_back(entry & 0xFFu);
+        bytes.push_back(entry >> 8u);
+    }
+    return bytes;
+}
+
+// Registers past the end of bytes are left as they are
+void GdbStub::WriteRegisters(Chip8& chip8, std::vector<uint8_t> const& bytes) const {
+    std::vector<uint8_t> all = ReadRegisters(chip8);
+    for (size_t i = 0; i < bytes.size() && i < all.size(); ++i) {all[i] = bytes[i];}
+
+    memcpy(chip8.registers, all.data(), sizeof(chip8.registers));
+    chip8.index = all[16] | (all[17] << 8u);
+    chip8.pc = (all[18] | (all[19] << 8u)) & 0x0FFFu;
+    chip8.sp = all[20] & 0x0Fu;                 // Keep the stack pointer inside the stack
+    chip8.delayTimer = all[21];
+    chip8.soundTimer = all[22];
+    for (unsigned int i = 0; i < 16; ++i) {chip8.stack[i] = all[23 + i * 2] | (all[24 + i * 2] << 8u);}
+}
+
+/* --------------------------- MEMORY ---------------------------- */
+// The same bookkeeping as an instruction writing memory, so forks and fused pairs notice (compiled code is checked again on Detach)
+void GdbStub::WriteByte(Chip8& chip8, uint16_t address, uint8_t value) {
+    chip8.memory[address] = value;
+    chip8.dirtyPages |= 1ull << (address / STATE_PAGE_SIZE);
+    if (chip8.Fusion()) {chip8.DecodeFusedPairs(address - 3, address);}  // Pairs starting up to 3 bytes before address include it
+}
+
+/* ---------------------------- TRAPS ---------------------------- */
+bool GdbStub::AddTrap(uint16_t address, uint8_t flag) {
+    if (address + 1u >= MEMORY_SIZE) {return false;}  // The instruction is two bytes, both must fit
+    traps[address] |= flag;
+    UpdateTrapBits();
+    return true;
+}
+
+void GdbStub::RemoveTrap(uint16_t address, uint8_t flag) {
+    auto trap = traps.find(address);
+    if (trap == traps.end()) {return;}
+    trap->second &= ~flag;
+    if (trap->second == 0) {traps.erase(trap);}
+    UpdateTrapBits();
+}
+
+void GdbStub::UpdateTrapBits() {
+    memset(trapBits, 0, sizeof(trapBits));
+    for (auto const& trap : traps) {trapBits[trap.first >> 6u] |= 1ull << (trap.first & 63u);}
+}
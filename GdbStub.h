@@ -0,0 +1,72 @@
+#ifndef GDBSTUB_H
+#define GDBSTUB_H
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "Chip8.h"
+#include "Debugger.h"
+
+/*
+A GDB remote serial protocol server on a localhost TCP port, for debugging a ROM while it runs.
+Registers, in the order of the g packet (16-bit values little-endian):
+    0-15  V0 to VF (8-bit)
+    16    I (16-bit)
+    17    PC (16-bit)
+    18    SP (8-bit)
+    19    DT (8-bit)
+    20    ST (8-bit)
+    21-36 stack[0] to stack[15] (16-bit)
+Memory is the 4KB address space. Supports stepping, continuing, breakpoints (Z0/Z1), write watchpoints (Z2)
+and Ctrl-C. One client at a time; once it detaches the ROM carries on without a debugger.
+
+Breakpoints never touch memory (see Debugger.h), so the ROM, savestates and forks see the same bytes
+as they would without a debugger.
+*/
+class GdbStub : public Debugger {
+    public:
+        // Methods
+        ~GdbStub();
+        bool Listen(uint16_t port);             // Open the port on 127.0.0.1 (false if it can't be)
+        bool Accept();                          // Wait for the debugger to connect
+        void Attach(Chip8& chip8);              // Start debugging chip8, stopped before its next instruction
+        void Poll(Chip8& chip8);                // Check for Ctrl-C or a lost connection while running, call once per frame
+        bool Killed() const;                    // The debugger asked for the program to be killed (k)
+
+        void Break(Chip8& chip8) override;
+        void MemoryWritten(Chip8& chip8, uint16_t address, unsigned int count) override;
+
+    private:
+        struct Watchpoint {
+            uint16_t address;
+            uint16_t length;
+        };
+
+        // Attributes
+        int listenFd = -1;
+        int clientFd = -1;
+        std::map<uint16_t, uint8_t> traps;      // Breakpoint address -> TRAP_USER and/or TRAP_TEMPORARY (trapBits has the same addresses)
+        std::vector<Watchpoint> watchpoints;
+        int stopSignal = 5;                     // Reason for the last stop, SIGTRAP or SIGINT
+        int watchAddress = -1;                  // Address that triggered a watchpoint, -1 if it wasn't one
+        bool resumed = false;                   // Whether the debugger is waiting for a stop reply
+        bool killed = false;
+
+        // Methods
+        bool HandlePacket(Chip8& chip8, std::string const& packet);  // Returns true when the program should carry on running
+        bool ReadPacket(std::string& packet);
+        bool WritePacket(std::string const& data);
+        void Detach(Chip8& chip8);
+        std::string StopReply() const;
+        std::vector<uint8_t> ReadRegisters(Chip8 const& chip8) const;
+        void WriteRegisters(Chip8& chip8, std::vector<uint8_t> const& bytes) const;
+        void WriteByte(Chip8& chip8, uint16_t address, uint8_t value);  // Write memory for the debugger (M packet)
+
+        // Trap bookkeeping
+        bool AddTrap(uint16_t address, uint8_t flag);
+        void RemoveTrap(uint16_t address, uint8_t flag);
+        void UpdateTrapBits();                  // Rebuild trapBits from traps
+};
+
+#endif
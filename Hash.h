@@ -0,0 +1,65 @@
+#ifndef HASH_H
+#define HASH_H
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+const uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325ull;   // Starting value for a fresh FNV-1a hash
+const uint64_t FNV_PRIME = 0x100000001B3ull;               // Multiplier used on every byte
+
+// 64-bit FNV-1a hash. Pass the previous result back in as hash to keep hashing across several buffers
+inline uint64_t Fnv1a(void const* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS) {
+    uint8_t const* bytes = static_cast<uint8_t const*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];                       // Mix in the byte
+        hash *= FNV_PRIME;                      // Spread it over the whole hash
+    }
+    return hash;
+}
+
+const uint64_t WORD_PRIME_1 = 0x9E3779B185EBCA87ull;       // Multipliers from xxHash64, chosen to spread bits well
+const uint64_t WORD_PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+const uint64_t WORD_PRIME_3 = 0x165667B19E3779F9ull;
+
+inline uint64_t RotateLeft(uint64_t value, unsigned int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint64_t MixWord(uint64_t lane, uint64_t word) {
+    return RotateLeft(lane + word * WORD_PRIME_2, 31) * WORD_PRIME_1;
+}
+
+/*
+64-bit hash that reads 8 bytes at a time on four independent lanes (in the style of xxHash64), for checksums over
+big blocks like savestates, where byte-at-a-time FNV-1a would be most of the cost. Not compatible with Fnv1a.
+*/
+inline uint64_t WordHash(void const* data, size_t size) {
+    uint8_t const* bytes = static_cast<uint8_t const*>(data);
+    uint64_t lanes[4] = {WORD_PRIME_1 + WORD_PRIME_2, WORD_PRIME_2, 0, 0 - WORD_PRIME_1};
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (unsigned int lane = 0; lane < 4; ++lane) {
+            uint64_t word;
+            memcpy(&word, bytes + i + lane * 8, sizeof(word));  // memcpy, as data doesn't have to be aligned
+            lanes[lane] = MixWord(lanes[lane], word);
+        }
+    }
+    uint64_t hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+    hash += size;
+    for (; i + 8 <= size; i += 8) {             // Whatever didn't fill all four lanes
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = RotateLeft(hash ^ MixWord(0, word), 27) * WORD_PRIME_1 + WORD_PRIME_3;
+    }
+    for (; i < size; ++i) {
+        hash = RotateLeft(hash ^ (bytes[i] * WORD_PRIME_3), 11) * WORD_PRIME_1;
+    }
+    hash ^= hash >> 33;                         // Final mix so every input bit affects every output bit
+    hash *= WORD_PRIME_2;
+    hash ^= hash >> 29;
+    hash *= WORD_PRIME_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+#endif
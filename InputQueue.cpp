@@ -0,0 +1,51 @@
+#include "InputQueue.h"
+
+/*
+NOTE: Dropping an event when the queue is full could lose a key up and leave the key stuck down. So the oldest
+event is taken out to make room and only its end result is kept (in overflow), which Apply() uses before anything
+else. It loses its exact timing, but every key still ends up in the right state.
+*/
+void InputQueue::Push(uint64_t timestamp, uint8_t key, bool pressed) {
+    if (head - tail == INPUT_QUEUE_SIZE) {
+        InputEvent const& oldest = events[tail % INPUT_QUEUE_SIZE];
+        overflow[oldest.key] = oldest.pressed;
+        overflowKeys |= 1u << oldest.key;
+        ++tail;
+    }
+    InputEvent& event = events[head % INPUT_QUEUE_SIZE];
+    event.timestamp = timestamp;
+    event.key = key;
+    event.pressed = pressed ? 1 : 0;
+    ++head;
+}
+
+/*
+NOTE: If a key goes down and back up before the next instruction, applying both at once would mean the ROM never
+sees the press. So once a key has changed, we stop and leave the rest of the queue for the next instruction.
+Stopping (rather than skipping just that key) keeps every event in the order it happened.
+*/
+void InputQueue::Apply(uint64_t time, uint8_t* keypad) {
+    uint16_t changed = overflowKeys;                // Bit n set if key n has changed in this call
+    for (unsigned int key = 0; key < 16; ++key) {   // Overflow is older than anything still queued, so it goes first
+        if (overflowKeys & (1u << key)) {keypad[key] = overflow[key];}
+    }
+    overflowKeys = 0;
+    while (tail != head) {
+        InputEvent const& event = events[tail % INPUT_QUEUE_SIZE];
+        if (event.timestamp > time) {break;}        // Happens after this instruction
+        if (changed & (1u << event.key)) {break;}   // Key already changed for this instruction
+        keypad[event.key] = event.pressed;
+        changed |= 1u << event.key;
+        ++tail;
+    }
+}
+
+bool InputQueue::Empty() const {
+    return head == tail && overflowKeys == 0;
+}
+
+uint64_t InputQueue::NextTimestamp() const {
+    if (overflowKeys) {return 0;}                   // Overflow is due straight away
+    if (head == tail) {return UINT64_MAX;}
+    return events[tail % INPUT_QUEUE_SIZE].timestamp;
+}
@@ -0,0 +1,36 @@
+#ifndef INPUTQUEUE_H
+#define INPUTQUEUE_H
+#include <cstddef>
+#include <cstdint>
+
+const size_t INPUT_QUEUE_SIZE = 256;    // Most key events that can be waiting at once (must be a power of two)
+
+// A key going down or up, and when it happened (nanoseconds, on the Platform::Now() clock)
+struct InputEvent {
+    uint64_t timestamp;
+    uint8_t key;                        // Keypad key 0 to F
+    uint8_t pressed;                    // 1 for down, 0 for up
+};
+
+/*
+Key events waiting to be applied to a keypad. Events go in as the platform reports them and come out
+in order, right before the emulated instruction whose time they happened at.
+*/
+class InputQueue {
+    public:
+        // Methods
+        void Push(uint64_t timestamp, uint8_t key, bool pressed);  // Add an event (if the queue is full, the oldest is folded into overflow)
+        void Apply(uint64_t time, uint8_t* keypad);  // Apply events that happened by time, but only one change per key
+        bool Empty() const;
+        uint64_t NextTimestamp() const;  // Timestamp of the oldest event waiting, UINT64_MAX if there are none
+
+    private:
+        // Attributes
+        InputEvent events[INPUT_QUEUE_SIZE];
+        size_t head = 0;                // Where the next event is pushed
+        size_t tail = 0;                // Oldest event not applied yet
+        uint8_t overflow[16]{};         // Latest state of each key pushed out of a full queue
+        uint16_t overflowKeys = 0;      // Bit n set if overflow[n] is waiting to be applied
+};
+
+#endif
@@ -0,0 +1,91 @@
+#include "Metrics.h"
+#include <chrono>   // Time functions
+#include <cmath>    // std::ceil
+#include <cstdio>   // snprintf
+#include <fstream>  // File operations
+
+const double TIMER_HZ = 60.0;   // Speed the delay and sound timers are meant to count down at
+
+uint64_t MetricsNowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* -------------------------- HISTOGRAM -------------------------- */
+void Histogram::Add(uint64_t micros) {
+    size_t bucket = 0;
+    while (micros > 1 && bucket < HISTOGRAM_BUCKETS - 1) {  // Find the highest set bit, that is the bucket
+        micros >>= 1;
+        ++bucket;
+    }
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+HistogramCounts Histogram::Take() {
+    HistogramCounts counts;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        counts.buckets[i] = buckets[i].exchange(0, std::memory_order_relaxed);  // Read and empty in one step
+    }
+    return counts;
+}
+
+uint64_t HistogramCounts::Count() const {
+    uint64_t total = 0;
+    for (uint64_t bucket : buckets) {total += bucket;}
+    return total;
+}
+
+uint64_t HistogramCounts::Percentile(double fraction) const {
+    uint64_t total = Count();
+    if (total == 0) {return 0;}
+    uint64_t target = static_cast<uint64_t>(std::ceil(fraction * total));  // How many samples must be at or below the answer
+    uint64_t seen = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= target) {return 2ull << i;}  // Upper edge of bucket i
+    }
+    return 2ull << (HISTOGRAM_BUCKETS - 1);
+}
+
+/* ---------------------------- METRICS -------------------------- */
+Metrics::Metrics()
+: startMicros(MetricsNowMicros()),
+  lastMicros(startMicros)
+{}
+
+/*
+NOTE: Chip8::Cycle() ticks the timers once per instruction rather than at 60Hz, so the timer drift is
+how many more (or fewer) ticks have happened than a real 60Hz clock would have given since startup.
+It is the only value in the report that isn't just for the interval since the last Report().
+*/
+std::string Metrics::Report() {
+    uint64_t now = MetricsNowMicros();
+    uint64_t executed = instructions.load(std::memory_order_relaxed);
+    uint64_t keyWaits = keyWaitCycles.load(std::memory_order_relaxed);
+    HistogramCounts frames = frameTime.Take();
+    HistogramCounts presents = presentTime.Take();
+    double interval = (now - lastMicros) / 1e6;
+    double elapsed = (now - startMicros) / 1e6;
+    double perSecond = interval > 0 ? (executed - lastInstructions) / interval : 0;
+    double timerDrift = executed - elapsed * TIMER_HZ;
+
+    char line[256];
+    snprintf(line, sizeof(line),
+        "t=%.1f ips=%.0f frame_p50_us=%llu frame_p99_us=%llu present_p50_us=%llu present_p99_us=%llu timer_drift_ticks=%.0f key_wait_cycles=%llu",
+        elapsed, perSecond,
+        (unsigned long long)frames.Percentile(0.5), (unsigned long long)frames.Percentile(0.99),
+        (unsigned long long)presents.Percentile(0.5), (unsigned long long)presents.Percentile(0.99),
+        timerDrift, (unsigned long long)(keyWaits - lastKeyWaitCycles));
+
+    lastMicros = now;
+    lastInstructions = executed;
+    lastKeyWaitCycles = keyWaits;
+    lastReport = line;
+    return lastReport;
+}
+
+bool Metrics::Export(char const* filename) const {
+    std::ofstream file(filename, std::ios::app);
+    if (!file.is_open()) {return false;}
+    file << lastReport << "\n";
+    return static_cast<bool>(file);
+}
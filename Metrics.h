@@ -0,0 +1,58 @@
+#ifndef METRICS_H
+#define METRICS_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+const size_t HISTOGRAM_BUCKETS = 24;    // Bucket n counts samples from 2^n to 2^(n+1) microseconds, so up to ~16 seconds
+
+// The bucket counts of a Histogram at one moment, see Histogram::Take()
+struct HistogramCounts {
+    uint64_t buckets[HISTOGRAM_BUCKETS]{};
+
+    uint64_t Count() const;                         // Total number of samples
+    uint64_t Percentile(double fraction) const;     // Upper edge (in microseconds) of the bucket holding that fraction of samples, e.g. 0.99
+};
+
+// Counts samples into power-of-two buckets. Adding a sample is one relaxed atomic increment, so any thread can feed it
+class Histogram {
+    public:
+        // Methods
+        void Add(uint64_t micros);                  // Record one sample
+        HistogramCounts Take();                     // Samples since the last Take(), emptying the histogram (a sample added meanwhile is never lost)
+
+    private:
+        // Attributes
+        std::atomic<uint64_t> buckets[HISTOGRAM_BUCKETS]{};
+};
+
+/*
+Runtime telemetry for one emulator. The counters are atomics updated with relaxed ordering, so the core and
+the main loop can feed them without locks and a reporter can read them at any time.
+*/
+class Metrics {
+    public:
+        // Attributes
+        std::atomic<uint64_t> instructions{0};      // Instructions executed (fed by main.cpp)
+        std::atomic<uint64_t> keyWaitCycles{0};     // Cycles spent stuck in Fx0A waiting for a key (fed by Chip8)
+        Histogram frameTime;                        // Time between two frames being shown
+        Histogram presentTime;                      // Time spent inside Platform::Update
+
+        // Methods
+        Metrics();                                  // Starts the clock used for rates and timer drift
+        std::string Report();                       // One line of key=value pairs covering everything since the last Report()
+        bool Export(char const* filename) const;    // Append the last Report() line to a file (a FIFO works too, for streaming to another process)
+
+    private:
+        // Attributes
+        uint64_t startMicros;                       // When this Metrics was created
+        uint64_t lastMicros;                        // When Report() was last called
+        uint64_t lastInstructions = 0;              // instructions at the last Report()
+        uint64_t lastKeyWaitCycles = 0;             // keyWaitCycles at the last Report()
+        std::string lastReport;                     // What Report() returned last time
+};
+
+uint64_t MetricsNowMicros();                        // Monotonic clock shared by everything that feeds a Metrics
+
+#endif
@@ -21,11 +21,51 @@ void Platform::Update(void const* buffer, int pitch) {
     SDL_UpdateTexture(texture, nullptr, buffer, pitch);
     SDL_RenderClear(renderer);
     SDL_RenderTexture(renderer, texture, nullptr, nullptr);  // Renamed, check here if errors
+    if (!overlay.empty()) {
+        SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);  // Red, so it stands out against the black and white display
+        SDL_RenderDebugText(renderer, 4, 4, overlay.c_str());
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);  // Back to black for the next SDL_RenderClear
+    }
     SDL_RenderPresent(renderer);
 }
 
-// Handle inputs
-bool Platform::ProcessInput(uint8_t* keys) {
+// Set the overlay text
+void Platform::SetOverlay(std::string const& text) {
+    overlay = text;
+}
+
+// Work out which keypad key (0 to F) a keyboard key is mapped to, or -1 if it isn't one
+/*
+Keyboard    Chip8
+1 2 3 4     1 2 3 C
+Q W E R     4 5 6 D
+A S D F     7 8 9 E
+Z X C V     A 0 B F
+*/
+static int KeyIndex(SDL_Keycode key) {
+    switch (key) {
+        case SDLK_X: return 0x0;
+        case SDLK_1: return 0x1;
+        case SDLK_2: return 0x2;
+        case SDLK_3: return 0x3;
+        case SDLK_Q: return 0x4;
+        case SDLK_W: return 0x5;
+        case SDLK_E: return 0x6;
+        case SDLK_A: return 0x7;
+        case SDLK_S: return 0x8;
+        case SDLK_D: return 0x9;
+        case SDLK_Z: return 0xA;
+        case SDLK_C: return 0xB;
+        case SDLK_4: return 0xC;
+        case SDLK_R: return 0xD;
+        case SDLK_F: return 0xE;
+        case SDLK_V: return 0xF;
+        default: return -1;
+    }
+}
+
+// Handle inputs, but queue them up with the time they happened instead of applying them straight away
+bool Platform::ProcessInput(InputQueue& queue) {
     bool quit = false;
     SDL_Event event;
     while (SDL_PollEvent(&event)) {  // While there is an event
@@ -33,179 +73,20 @@ bool Platform::ProcessInput(uint8_t* keys) {
             case SDL_EVENT_QUIT: {
                 quit = true;
             } break;
-            case SDL_EVENT_KEY_DOWN: {
-                switch (event.key.key) {
-                    case SDLK_ESCAPE:
-                    {
-                        quit = true;
-                    } break;
-
-                    case SDLK_X:
-                    {
-                        keys[0] = 1;
-                    } break;
-
-                    case SDLK_1:
-                    {
-                        keys[1] = 1;
-                    } break;
-
-                    case SDLK_2:
-                    {
-                        keys[2] = 1;
-                    } break;
-
-                    case SDLK_3:
-                    {
-                        keys[3] = 1;
-                    } break;
-
-                    case SDLK_Q:
-                    {
-                        keys[4] = 1;
-                    } break;
-
-                    case SDLK_W:
-                    {
-                        keys[5] = 1;
-                    } break;
-
-                    case SDLK_E:
-                    {
-                        keys[6] = 1;
-                    } break;
-
-                    case SDLK_A:
-                    {
-                        keys[7] = 1;
-                    } break;
-
-                    case SDLK_S:
-                    {
-                        keys[8] = 1;
-                    } break;
-
-                    case SDLK_D:
-                    {
-                        keys[9] = 1;
-                    } break;
-
-                    case SDLK_Z:
-                    {
-                        keys[0xA] = 1;
-                    } break;
-
-                    case SDLK_C:
-                    {
-                        keys[0xB] = 1;
-                    } break;
-
-                    case SDLK_4:
-                    {
-                        keys[0xC] = 1;
-                    } break;
-
-                    case SDLK_R:
-                    {
-                        keys[0xD] = 1;
-                    } break;
-
-                    case SDLK_F:
-                    {
-                        keys[0xE] = 1;
-                    } break;
-
-                    case SDLK_V:
-                    {
-                        keys[0xF] = 1;
-                    } break;
-                }
-            } break;
 
+            case SDL_EVENT_KEY_DOWN:
             case SDL_EVENT_KEY_UP: {
-                switch (event.key.key) {
-                    case SDLK_X:
-                    {
-                        keys[0] = 0;
-                    } break;
-
-                    case SDLK_1:
-                    {
-                        keys[1] = 0;
-                    } break;
-
-                    case SDLK_2:
-                    {
-                        keys[2] = 0;
-                    } break;
-
-                    case SDLK_3:
-                    {
-                        keys[3] = 0;
-                    } break;
-
-                    case SDLK_Q:
-                    {
-                        keys[4] = 0;
-                    } break;
-
-                    case SDLK_W:
-                    {
-                        keys[5] = 0;
-                    } break;
-
-                    case SDLK_E:
-                    {
-                        keys[6] = 0;
-                    } break;
-
-                    case SDLK_A:
-                    {
-                        keys[7] = 0;
-                    } break;
-
-                    case SDLK_S:
-                    {
-                        keys[8] = 0;
-                    } break;
-
-                    case SDLK_D:
-                    {
-                        keys[9] = 0;
-                    } break;
-
-                    case SDLK_Z:
-                    {
-                        keys[0xA] = 0;
-                    } break;
-
-                    case SDLK_C:
-                    {
-                        keys[0xB] = 0;
-                    } break;
-
-                    case SDLK_4:
-                    {
-                        keys[0xC] = 0;
-                    } break;
-
-                    case SDLK_R:
-                    {
-                        keys[0xD] = 0;
-                    } break;
-
-                    case SDLK_F:
-                    {
-                        keys[0xE] = 0;
-                    } break;
-
-                    case SDLK_V:
-                    {
-                        keys[0xF] = 0;
-                    } break;
-                }
+                if (event.key.key == SDLK_ESCAPE) {quit = true;}
+                if (event.key.repeat) {break;}  // Holding a key down sends repeats, the keypad only cares about the first
+                int key = KeyIndex(event.key.key);
+                if (key >= 0) {queue.Push(event.key.timestamp, key, event.type == SDL_EVENT_KEY_DOWN);}  // SDL timestamps are on the SDL_GetTicksNS() clock
             } break;
         }
     }
     return quit;  // Return if the program should be quit or not
 }
+
+// Current time in nanoseconds, on the same clock as SDL's event timestamps
+uint64_t Platform::Now() {
+    return SDL_GetTicksNS();
+}
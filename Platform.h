@@ -1,6 +1,8 @@
 #ifndef PLATFORM_H
 #define PLATFORM_H
 #include <SDL3/SDL.h>
+#include <string>
+#include "InputQueue.h"
 
 class Platform {
     public:
@@ -8,12 +10,15 @@ class Platform {
         SDL_Window* window;  // Pointer to the sdl window
         SDL_Renderer* renderer; // Pointer to the sdl renderer
         SDL_Texture* texture; // Pointer to the sdl texture
+        std::string overlay;  // Text drawn over the display, nothing is drawn when empty
 
         // Methods
     	Platform(char const* title, int windowWidth, int windowHeight, int textureWidth, int textureHeight);
         ~Platform();  // Destructor
         void Update(void const* buffer, int pitch);  // Update the display
-        bool ProcessInput(uint8_t* keys);  // You guessed it, process some input!
+        void SetOverlay(std::string const& text);  // Set the text drawn over the display (empty to turn it off)
+        bool ProcessInput(InputQueue& queue);  // You guessed it, process some input! Key events are timestamped and queued
+        uint64_t Now();  // Current time in nanoseconds, on the same clock as the queued key events
 };
 
 #endif
\ No newline at end of file
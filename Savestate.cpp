@@ -0,0 +1,111 @@
+#include "Savestate.h"
+#include "Hash.h"
+#include "Aot.h"
+#include <fstream>      // File operations
+#include <string>
+#include <cstdio>       // std::rename and std::remove
+#include <string.h>     // To use memcpy and memcmp
+#include <fcntl.h>      // open
+#include <sys/mman.h>   // mmap
+#include <sys/stat.h>   // fstat
+#include <unistd.h>     // close
+
+const char SAVESTATE_MAGIC[4] = {'C', '8', 'S', 'S'};
+
+// If any of these fail the layout has padding in it, and files would differ between compilers
+static_assert(sizeof(SavestateHeader) == 24, "SavestateHeader must have no padding");
+static_assert(sizeof(SavestatePayload) == 8 + 8192 + 4096 + 16 + 32 + 2 + 2 + 4 + 8, "SavestatePayload must have no padding");
+static_assert(sizeof(Savestate) == sizeof(SavestateHeader) + sizeof(SavestatePayload), "Savestate must have no padding");
+
+/* ------------------------ IN-MEMORY COPY ----------------------- */
+void WriteSavestate(Chip8 const& chip8, Savestate& state) {
+    SavestatePayload& p = state.payload;
+    p.romHash = chip8.romHash;
+    memcpy(p.video, chip8.video, sizeof(p.video));
+    memcpy(p.memory, chip8.memory, sizeof(p.memory));
+    memcpy(p.registers, chip8.registers, sizeof(p.registers));
+    memcpy(p.stack, chip8.stack, sizeof(p.stack));
+    p.pc = chip8.pc;
+    p.index = chip8.index;
+    p.randState = chip8.randState;
+    p.sp = chip8.sp;
+    p.delayTimer = chip8.delayTimer;
+    p.soundTimer = chip8.soundTimer;
+    memset(p.reserved, 0, sizeof(p.reserved));
+
+    SavestateHeader& h = state.header;
+    memcpy(h.magic, SAVESTATE_MAGIC, sizeof(h.magic));
+    h.version = SAVESTATE_VERSION;
+    h.byteOrder = SAVESTATE_BYTE_ORDER;
+    h.payloadSize = sizeof(SavestatePayload);
+    h.reserved = 0;
+    h.checksum = WordHash(&p, sizeof(p));          // Checksum goes last, once the payload is filled in
+}
+
+bool ReadSavestate(void const* data, size_t size, Chip8& chip8) {
+    if (size < sizeof(Savestate)) {return false;}  // Truncated (or not a savestate at all)
+
+    // The block might not be aligned (e.g. it came from a network buffer), so copy the header out before reading it
+    SavestateHeader h;
+    memcpy(&h, data, sizeof(h));
+    if (memcmp(h.magic, SAVESTATE_MAGIC, sizeof(h.magic)) != 0) {return false;}
+    if (h.byteOrder != SAVESTATE_BYTE_ORDER) {return false;}    // Written by a host with the other endianness
+    if (h.version != SAVESTATE_VERSION || h.payloadSize != sizeof(SavestatePayload)) {return false;}
+
+    uint8_t const* payloadBytes = static_cast<uint8_t const*>(data) + sizeof(SavestateHeader);
+    if (WordHash(payloadBytes, sizeof(SavestatePayload)) != h.checksum) {return false;}  // Corrupt
+
+    // Everything checks out, copy straight out of the block into the Chip8
+    memcpy(chip8.video, payloadBytes + offsetof(SavestatePayload, video), sizeof(chip8.video));
+    memcpy(chip8.memory, payloadBytes + offsetof(SavestatePayload, memory), sizeof(chip8.memory));
+    memcpy(chip8.registers, payloadBytes + offsetof(SavestatePayload, registers), sizeof(chip8.registers));
+    memcpy(chip8.stack, payloadBytes + offsetof(SavestatePayload, stack), sizeof(chip8.stack));
+    memcpy(&chip8.pc, payloadBytes + offsetof(SavestatePayload, pc), sizeof(chip8.pc));
+    memcpy(&chip8.index, payloadBytes + offsetof(SavestatePayload, index), sizeof(chip8.index));
+    memcpy(&chip8.randState, payloadBytes + offsetof(SavestatePayload, randState), sizeof(chip8.randState));
+    memcpy(&chip8.romHash, payloadBytes + offsetof(SavestatePayload, romHash), sizeof(chip8.romHash));
+    chip8.sp = payloadBytes[offsetof(SavestatePayload, sp)];
+    chip8.delayTimer = payloadBytes[offsetof(SavestatePayload, delayTimer)];
+    chip8.soundTimer = payloadBytes[offsetof(SavestatePayload, soundTimer)];
+    if (chip8.randState == 0) {chip8.randState = 1;}    // Same rule as Chip8::Reset, xorshift gets stuck on 0
+    chip8.aot = FindAotModule(chip8.romHash, chip8.memory);  // Memory has been replaced, so re-check the compiled code still fits
+    chip8.dirtyPages = ALL_PAGES_DIRTY;
+    if (chip8.Fusion()) {chip8.DecodeFusedPairs();}
+    return true;
+}
+
+/* ------------------------- FILE SAVE/LOAD ---------------------- */
+bool SaveState(Chip8 const& chip8, char const* filename) {
+    Savestate state;
+    WriteSavestate(chip8, state);
+
+    std::string tempName = std::string(filename) + ".tmp";
+    std::ofstream file(tempName, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {return false;}
+    file.write(reinterpret_cast<char const*>(&state), sizeof(state));
+    file.close();
+    if (!file) {                                // Disk full or similar, don't replace a good savestate with a bad one
+        std::remove(tempName.c_str());
+        return false;
+    }
+    return std::rename(tempName.c_str(), filename) == 0;
+}
+
+bool LoadState(Chip8& chip8, char const* filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {return false;}
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Savestate)) {
+        close(fd);                              // Don't even map a truncated file
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, sizeof(Savestate), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);                                  // The mapping keeps the file alive, the descriptor isn't needed any more
+    if (mapped == MAP_FAILED) {return false;}
+
+    bool loaded = ReadSavestate(mapped, sizeof(Savestate), chip8);
+    munmap(mapped, sizeof(Savestate));
+    return loaded;
+}
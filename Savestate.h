@@ -0,0 +1,54 @@
+#ifndef SAVESTATE_H
+#define SAVESTATE_H
+#include <cstddef>
+#include <cstdint>
+#include "Chip8.h"
+
+const uint16_t SAVESTATE_VERSION = 3;           // Bump this whenever the layout below changes
+const uint16_t SAVESTATE_BYTE_ORDER = 0x0102;   // Written natively, reads back as 0x0201 on a host with the other endianness
+
+/*
+The on-disk layout of a savestate. It is a fixed-size block with no pointers or variable-length parts,
+so loading is just mapping the file and copying bytes out of it; nothing has to be parsed.
+Fields are ordered largest to smallest so the compiler never needs to add padding (checked in Savestate.cpp).
+*/
+struct SavestateHeader {
+    char magic[4];                  // Always "C8SS"
+    uint16_t version;               // SAVESTATE_VERSION of the writer
+    uint16_t byteOrder;             // SAVESTATE_BYTE_ORDER of the writer
+    uint32_t payloadSize;           // sizeof(SavestatePayload) of the writer
+    uint32_t reserved;              // Always 0, keeps the checksum 8-byte aligned
+    uint64_t checksum;              // WordHash (Hash.h) of the payload
+};
+
+struct SavestatePayload {
+    uint64_t romHash;               // Chip8::romHash, to find the ROM's compiled code without searching every module
+    uint32_t video[64 * 32];        // Display
+    uint8_t memory[4096];           // Whole 4KB of memory (font and ROM included)
+    uint8_t registers[16];          // V0 to VF
+    uint16_t stack[16];             // 16-layer stack
+    uint16_t pc;                    // Program counter
+    uint16_t index;                 // Index register
+    uint32_t randState;             // RNG state, so Cxkk carries on with the same numbers after a load
+    uint8_t sp;                     // Stack pointer
+    uint8_t delayTimer;
+    uint8_t soundTimer;
+    uint8_t reserved[5];            // Always 0, pads the payload to a multiple of 8 bytes
+};
+
+struct Savestate {
+    SavestateHeader header;
+    SavestatePayload payload;
+};
+
+// Copy a Chip8 into a savestate block (filling in the header and checksum)
+void WriteSavestate(Chip8 const& chip8, Savestate& state);
+// Check a savestate block and copy it into a Chip8. Returns false (leaving chip8 untouched) if size is short or the block is invalid
+bool ReadSavestate(void const* data, size_t size, Chip8& chip8);
+
+// Save a Chip8 to a file. The file is written next to the target and renamed over it, so a crash never leaves half a savestate
+bool SaveState(Chip8 const& chip8, char const* filename);
+// Load a Chip8 from a file by mapping it into memory. Returns false for missing, truncated, corrupt or foreign files
+bool LoadState(Chip8& chip8, char const* filename);
+
+#endif
@@ -0,0 +1,115 @@
+#include "Tracer.h"
+#include <csignal>      // Signal handlers
+#include <string.h>     // To use memcpy and strncpy
+#include <fcntl.h>      // open
+#include <unistd.h>     // write and close
+
+/* ------------------------- CONSTRUCTOR ------------------------- */
+Tracer::Tracer(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {size <<= 1;}      // Round up to a power of two so wrapping is a cheap AND
+    records.resize(size);
+    mask = size - 1;
+}
+
+/* --------------------------- RECORDING ------------------------- */
+void Tracer::Begin(uint16_t pc, uint16_t opcode, uint16_t index, uint8_t const* registers) {
+    uint64_t sequence = head.load(std::memory_order_relaxed);  // Only this thread writes head, so relaxed is enough here
+    TraceRecord& record = records[sequence & mask];
+
+    record.pc = pc;
+    record.opcode = opcode;
+    record.index = index;
+    record.changedRegisters = 0;
+    memcpy(record.registers, registers, sizeof(record.registers));
+
+    head.store(sequence + 1, std::memory_order_release);        // Publish now, so a crash in this instruction still dumps it
+}
+
+// Fill in the record Begin() published, now that the instruction has run
+void Tracer::Finish(uint16_t index, uint8_t const* registers) {
+    TraceRecord& record = records[(head.load(std::memory_order_relaxed) - 1) & mask];
+
+    record.index = index;
+    uint16_t changed = 0;
+    for (unsigned int i = 0; i < 16; ++i) {     // Begin() left the registers from before the instruction in the record
+        if (registers[i] != record.registers[i]) {changed |= 1u << i;}
+    }
+    record.changedRegisters = changed;
+    memcpy(record.registers, registers, sizeof(record.registers));
+}
+
+void Tracer::Clear() {
+    head.store(0, std::memory_order_release);
+}
+
+/* ---------------------------- DUMPING -------------------------- */
+// write() can stop part way through, so keep going until everything is out
+static bool WriteAll(int fd, void const* data, size_t size) {
+    char const* bytes = static_cast<char const*>(data);
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written <= 0) {return false;}
+        bytes += written;
+        size -= written;
+    }
+    return true;
+}
+
+/*
+NOTE: The dump is lock-free, so if the emulator is still running while it happens the oldest few records
+might be overwritten mid-dump. Dump from the emulator's thread (or after it has crashed) for an exact copy.
+*/
+bool Tracer::Dump(int fd) const {
+    uint64_t end = head.load(std::memory_order_acquire);
+    uint64_t capacity = mask + 1;
+    uint64_t start = end > capacity ? end - capacity : 0;       // Only the last capacity records are still in the ring
+
+    TraceDumpHeader header;
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.recordSize = sizeof(TraceRecord);
+    header.firstSequence = start;
+    header.count = end - start;
+    if (!WriteAll(fd, &header, sizeof(header))) {return false;}
+
+    // The ring wraps, so the records are written in (at most) two pieces: oldest to end of ring, then start of ring
+    size_t first = start & mask;
+    size_t firstCount = capacity - first < header.count ? capacity - first : header.count;
+    if (!WriteAll(fd, &records[first], firstCount * sizeof(TraceRecord))) {return false;}
+    return WriteAll(fd, &records[0], (header.count - firstCount) * sizeof(TraceRecord));
+}
+
+bool Tracer::Dump(char const* filename) const {
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {return false;}
+    bool dumped = Dump(fd);
+    close(fd);
+    return dumped;
+}
+
+/* ------------------------ SIGNAL HANDLING ---------------------- */
+// Signal handlers can't take arguments, so the tracer and filename live here
+static Tracer* signalTracer = nullptr;
+static char signalFilename[1024];
+
+static void DumpSignalHandler(int signal) {
+    int fd = open(signalFilename, O_WRONLY | O_CREAT | O_TRUNC, 0644);  // open/write/close are all signal-safe
+    if (fd >= 0) {
+        signalTracer->Dump(fd);
+        close(fd);
+    }
+    if (signal != SIGUSR1) {                    // A real crash: put the default handler back and let it kill the process
+        std::signal(signal, SIG_DFL);
+        std::raise(signal);
+    }
+}
+
+void DumpTraceOnSignal(Tracer* tracer, char const* filename) {
+    signalTracer = tracer;
+    strncpy(signalFilename, filename, sizeof(signalFilename) - 1);
+    int signals[] = {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT, SIGUSR1};
+    for (int signal : signals) {
+        std::signal(signal, DumpSignalHandler);
+    }
+}
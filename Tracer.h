@@ -0,0 +1,56 @@
+#ifndef TRACER_H
+#define TRACER_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const char TRACE_MAGIC[4] = {'C', '8', 'T', 'R'};
+const uint16_t TRACE_VERSION = 1;
+
+// One executed instruction. Fixed size so the dump file is just an array of these
+struct TraceRecord {
+    uint16_t pc;                    // Address the instruction was fetched from
+    uint16_t opcode;                // The instruction itself
+    uint16_t index;                 // Index register after the instruction
+    uint16_t changedRegisters;      // Bit n is set if the instruction changed Vn
+    uint8_t registers[16];          // V0 to VF after the instruction
+};
+// NOTE: A record is published before its instruction runs, so if that instruction crashes the last record is still
+// in the dump, with index and registers as they were before it (and changedRegisters 0)
+
+// Header at the start of a dump file, followed by count TraceRecords (oldest first)
+struct TraceDumpHeader {
+    char magic[4];                  // Always "C8TR"
+    uint16_t version;               // TRACE_VERSION of the writer
+    uint16_t recordSize;            // sizeof(TraceRecord) of the writer
+    uint64_t firstSequence;         // Sequence number of the first record (how many records were overwritten before it)
+    uint64_t count;                 // Number of records that follow
+};
+
+/*
+A ring buffer holding the last N instructions a Chip8 executed.
+There is one writer (the thread running Cycle()) and the position is published with an atomic, so a dump
+never has to take a lock. Point Chip8::tracer at one to start tracing and set it back to nullptr to stop.
+*/
+class Tracer {
+    public:
+        // Methods
+        explicit Tracer(size_t capacity);   // Capacity is rounded up to a power of two
+        void Begin(uint16_t pc, uint16_t opcode, uint16_t index, uint8_t const* registers);  // Called by Chip8::Cycle() before running an instruction
+        void Finish(uint16_t index, uint8_t const* registers);  // And after it, to fill in what it changed
+        bool Dump(int fd) const;            // Write a dump to an open file. Only uses write(), so it is safe in a signal handler
+        bool Dump(char const* filename) const;  // Same as above but opens (and replaces) the file for you
+        void Clear();                       // Forget everything recorded so far (only call from the writer's thread)
+
+    private:
+        // Attributes
+        std::vector<TraceRecord> records;   // The ring itself
+        size_t mask;                        // capacity - 1, used instead of % to wrap
+        std::atomic<uint64_t> head{0};      // Total number of records ever written
+};
+
+// Dump tracer to filename if the process crashes (SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT) or gets SIGUSR1 (dump on demand)
+void DumpTraceOnSignal(Tracer* tracer, char const* filename);
+
+#endif
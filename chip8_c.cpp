@@ -0,0 +1,86 @@
+#include "chip8_c.h"
+#include "Chip8.h"
+#include "Aot.h"
+#include <new>      // std::nothrow, exceptions must never cross into C
+
+// chip8_t only exists as a name on the C side, every handle is really a Chip8
+static Chip8* ToChip8(chip8_t* chip8) {return reinterpret_cast<Chip8*>(chip8);}
+static Chip8 const* ToChip8(chip8_t const* chip8) {return reinterpret_cast<Chip8 const*>(chip8);}
+
+static_assert(sizeof(Chip8::video) == CHIP8_VIDEO_WIDTH * CHIP8_VIDEO_HEIGHT * sizeof(uint32_t), "Video size doesn't match chip8_c.h");
+
+/* ---------------------------- LIFETIME ------------------------- */
+uint32_t chip8_abi_version(void) {
+    return CHIP8_ABI_VERSION;
+}
+
+chip8_t* chip8_create(uint32_t seed) {
+    return reinterpret_cast<chip8_t*>(new (std::nothrow) Chip8(seed));
+}
+
+void chip8_destroy(chip8_t* chip8) {
+    delete ToChip8(chip8);
+}
+
+void chip8_reset(chip8_t* chip8, uint32_t seed) {
+    ToChip8(chip8)->Reset(seed);
+}
+
+int chip8_load_rom(chip8_t* chip8, uint8_t const* data, size_t size) {
+    return ToChip8(chip8)->LoadROM(data, size) ? 1 : 0;
+}
+
+int chip8_load_aot_module(char const* filename) {
+    return LoadAotModule(filename) ? 1 : 0;
+}
+
+/* ---------------------------- STEPPING ------------------------- */
+void chip8_step(chip8_t* chip8, uint32_t cycles) {
+    ToChip8(chip8)->Run(cycles);
+}
+
+void chip8_step_many(chip8_t* const* chip8s, size_t count, uint32_t cycles) {
+    for (size_t i = 0; i < count; ++i) {
+        ToChip8(chip8s[i])->Run(cycles);
+    }
+}
+
+/* ----------------------------- INPUT --------------------------- */
+void chip8_set_key(chip8_t* chip8, uint8_t key, int pressed) {
+    ToChip8(chip8)->keypad[key & 0xFu] = pressed ? 1 : 0;
+}
+
+void chip8_set_keys(chip8_t* chip8, uint16_t pressed) {
+    Chip8* c = ToChip8(chip8);
+    for (unsigned int key = 0; key < 16; ++key) {
+        c->keypad[key] = (pressed >> key) & 1u;
+    }
+}
+
+/* ---------------------------- MEMORY --------------------------- */
+int chip8_write_memory(chip8_t* chip8, uint16_t address, uint8_t const* data, size_t size) {
+    return ToChip8(chip8)->WriteMemory(address, data, size) ? 1 : 0;
+}
+
+/* ------------------------- OBSERVATIONS ------------------------ */
+void chip8_get_view(chip8_t* chip8, chip8_view* view) {
+    Chip8* c = ToChip8(chip8);
+    view->video = c->video;
+    view->registers = c->registers;
+    view->memory = c->memory;
+    view->stack = c->stack;
+    view->keypad = c->keypad;
+    view->pc = &c->pc;
+    view->index = &c->index;
+    view->sp = &c->sp;
+    view->delay_timer = &c->delayTimer;
+    view->sound_timer = &c->soundTimer;
+}
+
+uint32_t const* chip8_video(chip8_t const* chip8) {
+    return ToChip8(chip8)->video;
+}
+
+uint8_t* chip8_registers(chip8_t* chip8) {
+    return ToChip8(chip8)->registers;
+}
@@ -0,0 +1,68 @@
+#ifndef CHIP8_C_H
+#define CHIP8_C_H
+/*
+C interface to the emulator, built into libchip8 (see README.md).
+Everything here is plain C so it can be loaded from Python (ctypes/cffi), Rust, etc.
+The layout of chip8_view and the meaning of every function are fixed for a given CHIP8_ABI_VERSION.
+*/
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#define CHIP8_API __declspec(dllexport)
+#else
+#define CHIP8_API __attribute__((visibility("default")))
+#endif
+
+#define CHIP8_ABI_VERSION 2     /* Bumped whenever anything in this file changes incompatibly */
+#define CHIP8_VIDEO_WIDTH 64
+#define CHIP8_VIDEO_HEIGHT 32
+
+typedef struct chip8_t chip8_t; /* Opaque handle to one emulator instance */
+
+/* Pointers straight into an instance's own state. They stay valid until the instance is destroyed,
+   so fetch them once and read them after every step: no copying is ever done.
+   Video and memory are read only, change memory with chip8_write_memory so compiled code, fused pairs and forks see it. */
+typedef struct chip8_view {
+    uint32_t const* video;      /* CHIP8_VIDEO_WIDTH * CHIP8_VIDEO_HEIGHT pixels, 0 (off) or 0xFFFFFFFF (on) */
+    uint8_t* registers;         /* V0 to VF */
+    uint8_t const* memory;      /* 4096 bytes */
+    uint16_t* stack;            /* 16 entries */
+    uint8_t* keypad;            /* 16 keys, non-zero means pressed */
+    uint16_t* pc;
+    uint16_t* index;
+    uint8_t* sp;
+    uint8_t* delay_timer;
+    uint8_t* sound_timer;
+} chip8_view;
+
+CHIP8_API uint32_t chip8_abi_version(void);                 /* Returns CHIP8_ABI_VERSION the library was built with */
+
+CHIP8_API chip8_t* chip8_create(uint32_t seed);             /* NULL if out of memory. seed drives the Cxkk RNG */
+CHIP8_API void chip8_destroy(chip8_t* chip8);               /* NULL is ignored */
+CHIP8_API void chip8_reset(chip8_t* chip8, uint32_t seed);  /* Back to power-on state, the view stays valid */
+
+CHIP8_API int chip8_load_rom(chip8_t* chip8, uint8_t const* data, size_t size);  /* 1 on success, 0 if it doesn't fit */
+CHIP8_API int chip8_load_aot_module(char const* filename);  /* Register a module from tools/chip8_aot.cpp, used by later chip8_load_rom calls. 1 on success */
+
+CHIP8_API void chip8_step(chip8_t* chip8, uint32_t cycles);  /* Run cycles instructions */
+CHIP8_API void chip8_step_many(chip8_t* const* chip8s, size_t count, uint32_t cycles);  /* Same for a batch of instances, one FFI call */
+
+CHIP8_API void chip8_set_key(chip8_t* chip8, uint8_t key, int pressed);  /* key is 0x0 to 0xF */
+CHIP8_API void chip8_set_keys(chip8_t* chip8, uint16_t pressed);         /* Bit n set means key n is pressed */
+
+CHIP8_API int chip8_write_memory(chip8_t* chip8, uint16_t address, uint8_t const* data, size_t size);  /* 1 on success, 0 if it runs past the end of memory */
+
+CHIP8_API void chip8_get_view(chip8_t* chip8, chip8_view* view);
+CHIP8_API uint32_t const* chip8_video(chip8_t const* chip8);  /* Shortcuts for the two most used fields of the view */
+CHIP8_API uint8_t* chip8_registers(chip8_t* chip8);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -2,10 +2,18 @@
 #include <chrono>
 #include "Chip8.h"
 #include "Platform.h"
+#include "Tracer.h"
+#include "Metrics.h"
+#include "InputQueue.h"
+#include "Aot.h"
+#include "GdbStub.h"
 using namespace std;
 
 const unsigned int VIDEO_HEIGHT = 32;           // Stores height of the display
 const unsigned int VIDEO_WIDTH = 64;            // Stores width of the display
+const uint64_t MAX_CATCH_UP_NANOS = 250000000;  // Most emulated time (0.25s) one pass of the main loop will try to catch up on
+const uint64_t FRAME_NANOS = 16666667;          // One 60Hz display frame
+const uint64_t RUN_AHEAD_BUDGET_NANOS = FRAME_NANOS / 2;  // Most of a frame run-ahead may take, the rest is for emulating and presenting
 
 // Called when run
 /* CLI ARGS:
@@ -13,12 +21,20 @@ const unsigned int VIDEO_WIDTH = 64;            // Stores width of the display
     2 - The scale to increase the display size by
     3 - Delay (essentially clock speed, the time between instructions)
     4 - ROM file to open
+    Optional, after the ROM:
+    --trace <file> - Keep a trace of the last instructions, written to file on a crash or when sent SIGUSR1
+    --metrics <file> - Append a line of performance metrics to file every second
+    --overlay - Show the performance metrics on top of the display
+    --aot <module> - Load natively compiled ROM code built with tools/chip8_aot.cpp (used if it matches the ROM)
+    --fuse - Run common pairs of instructions as one (see Chip8::SetFusion)
+    --runahead <frames> - Show the display as it will be this many frames from now, to hide the ROM's own input lag
+    --gdb <port> - Wait for a GDB remote debugger on localhost:port before starting (see GdbStub.h)
 */
 int main(int argc, const char* argv[]) {
     // argc: Number of command line args
     // argv: Pointer to array of command line arguaments
-    if (argc != 4) {  // There must be 4 command line args (3 for the games, 1 for the file itself)
-        cerr << "Usage: " << argv[0] << " <Scale> <Delay> <ROM>\n";  // Output error message for wrong num of args
+    if (argc < 4) {  // There must be at least 4 command line args (3 for the games, 1 for the file itself)
+        cerr << "Usage: " << argv[0] << " <Scale> <Delay> <ROM> [--trace <file>] [--metrics <file>] [--overlay] [--aot <module>] [--fuse] [--runahead <frames>] [--gdb <port>]\n";  // Output error message for wrong num of args
         exit(EXIT_FAILURE);  // Stop the program
     }
 
@@ -26,6 +42,37 @@ int main(int argc, const char* argv[]) {
     int videoScale = stoi(argv[1]);  // Stoi: Cast string to int
     int cycleDelay = stoi(argv[2]);
     char const* romFilename = argv[3];
+    char const* traceFilename = nullptr;
+    char const* metricsFilename = nullptr;
+    bool showOverlay = false;
+    bool fuseInstructions = false;
+    int runAheadFrames = 0;
+    int gdbPort = 0;
+
+    for (int i = 4; i < argc; ++i) {  // Look through the optional args
+        string option = argv[i];
+        if (option == "--trace" && i + 1 < argc) {
+            traceFilename = argv[++i];
+        } else if (option == "--metrics" && i + 1 < argc) {
+            metricsFilename = argv[++i];
+        } else if (option == "--overlay") {
+            showOverlay = true;
+        } else if (option == "--runahead" && i + 1 < argc) {
+            runAheadFrames = stoi(argv[++i]);
+        } else if (option == "--gdb" && i + 1 < argc) {
+            gdbPort = stoi(argv[++i]);
+        } else if (option == "--fuse") {
+            fuseInstructions = true;
+        } else if (option == "--aot" && i + 1 < argc) {
+            if (!LoadAotModule(argv[++i])) {
+                cerr << "Could not load compiled module: " << argv[i] << "\n";
+                exit(EXIT_FAILURE);
+            }
+        } else {
+            cerr << "Unknown option: " << option << "\n";
+            exit(EXIT_FAILURE);
+        }
+    }
 
     // Instantiate platform layer
     Platform platform(
@@ -37,23 +84,131 @@ int main(int argc, const char* argv[]) {
     );
 
     // Instantiate emulator
-    Chip8 chip8;
+    Chip8 chip8(chrono::system_clock::now().time_since_epoch().count());  // Seed the RNG using the current time
     chip8.LoadROM(romFilename);
+    chip8.SetFusion(fuseInstructions);
+
+    Tracer tracer(64 * 1024);  // Room for the last 64K instructions
+    if (traceFilename) {
+        chip8.tracer = &tracer;
+        DumpTraceOnSignal(&tracer, traceFilename);
+    }
+
+    Metrics metrics;
+    bool collectMetrics = metricsFilename || showOverlay;
+    if (collectMetrics) {chip8.metrics = &metrics;}
+    uint64_t lastFrameMicros = MetricsNowMicros();
+    uint64_t lastReportMicros = lastFrameMicros;
+
+    GdbStub gdb;
+    if (gdbPort) {
+        if (!gdb.Listen(gdbPort)) {
+            cerr << "Could not listen for GDB on port " << gdbPort << "\n";
+            exit(EXIT_FAILURE);
+        }
+        cerr << "Waiting for GDB on localhost:" << gdbPort << "\n";
+        if (!gdb.Accept()) {
+            cerr << "GDB failed to connect\n";
+            exit(EXIT_FAILURE);
+        }
+        gdb.Attach(chip8);
+        if (runAheadFrames > 0) {
+            runAheadFrames = 0;  // The copy would run into breakpoints with nobody to stop it
+            cerr << "Run-ahead is off while debugging\n";
+        }
+    }
 
     int videoPitch = sizeof(chip8.video[0]) * VIDEO_WIDTH;
-    auto lastCycleTime = chrono::high_resolution_clock::now();  // Get the current time
+    uint64_t cycleNanos = cycleDelay > 0 ? cycleDelay * 1000000ull : 0;  // Time between instructions, on the same clock as input events
+    uint64_t nextCycleTime = platform.Now();  // When the next instruction is due
+    uint64_t nextFrameTime = nextCycleTime;  // When the display is next due to be shown
+    uint32_t executed = 0;  // Instructions run since the display was last shown
+    InputQueue inputQueue;
     bool quit = false;
 
+    Chip8 ahead;  // Scratch copy for run-ahead, made once so the loop never has to build one
+    uint32_t cyclesPerFrame = cycleNanos > 0 && cycleNanos < FRAME_NANOS ? FRAME_NANOS / cycleNanos : 1;
+
     while (!quit) {  // Keep iterating until the user quits
-        quit = platform.ProcessInput(chip8.keypad);
-        auto currentTime = chrono::high_resolution_clock::now();
-        float dt = std::chrono::duration<float, std::milli>(currentTime - lastCycleTime).count();  // Get the time since last instruction in milliseconds
+        quit = platform.ProcessInput(inputQueue);
+        if (chip8.debugger) {gdb.Poll(chip8);}  // Ctrl-C from the debugger
+        if (gdb.Killed()) {quit = true;}
+        uint64_t currentTime = platform.Now();
+        if (currentTime > nextCycleTime + MAX_CATCH_UP_NANOS) {
+            nextCycleTime = currentTime;  // We fell a long way behind (e.g. the window was being dragged), don't try to run it all at once
+        }
+
+        /*
+        Run every instruction that is due since the last pass, in one batch.
+        Each instruction has its own emulated time, and any key events stamped before that time are applied
+        right before it runs, so input lands on the same instruction no matter how often this loop comes around.
+        */
+        while (nextCycleTime <= currentTime) {
+            inputQueue.Apply(nextCycleTime, chip8.keypad);
+
+            // Everything up to the next key event (or the end of the batch) can run in one go
+            uint64_t lastTime = currentTime;
+            uint64_t nextEvent = inputQueue.NextTimestamp();
+            if (nextEvent <= nextCycleTime) {
+                lastTime = nextCycleTime;  // An event is being held back for the next instruction, so run just one
+            } else if (nextEvent - 1 < lastTime) {
+                lastTime = nextEvent - 1;
+            }
+            uint32_t cycles = cycleNanos == 0 ? 1 : (lastTime - nextCycleTime) / cycleNanos + 1;
+
+            chip8.Run(cycles);
+            executed += cycles;
+            if (cycleNanos == 0) {  // No delay, so just one instruction per pass
+                nextCycleTime = currentTime + 1;
+            } else {
+                nextCycleTime += cycles * cycleNanos;
+            }
+        }
+
+        // Show the display (and run ahead) once per 60Hz frame, however many batches ran in between
+        if (executed == 0 || currentTime < nextFrameTime) {continue;}
+        nextFrameTime += FRAME_NANOS;
+        if (nextFrameTime <= currentTime) {nextFrameTime = currentTime + FRAME_NANOS;}  // Fell behind, don't try to show the missed frames
+
+        /*
+        Run-ahead: lots of ROMs take a frame or more to show the result of a key press. So instead of showing the real
+        machine, copy it and run the copy runAheadFrames frames into the future (with the keys as they are now, and
+        without drawing anything), then show the copy's display. The real machine is never touched, so the next
+        pass carries on from the real state exactly as if nothing happened - the copy *is* the snapshot/restore.
+        */
+        uint32_t const* shownVideo = chip8.video;
+        if (runAheadFrames > 0) {
+            uint64_t aheadStart = platform.Now();
+            ahead = chip8;  // Chip8 is trivially copyable, so this is one ~12KB memcpy
+            ahead.tracer = nullptr;  // The speculative instructions never really happened, so keep them out of the trace...
+            ahead.metrics = nullptr;  // ...and the metrics
+            ahead.Run(runAheadFrames * cyclesPerFrame);
+            shownVideo = ahead.video;
+            if (platform.Now() - aheadStart > RUN_AHEAD_BUDGET_NANOS) {  // Running ahead is taking too much of the frame, back off
+                --runAheadFrames;
+                cerr << "Run-ahead is too slow on this machine, dropping to " << runAheadFrames << " frames\n";
+            }
+        }
+
+        if (collectMetrics) {
+            uint64_t presentStart = MetricsNowMicros();
+            platform.Update(shownVideo, videoPitch);
+            uint64_t presentEnd = MetricsNowMicros();
+            metrics.instructions.fetch_add(executed, std::memory_order_relaxed);
+            metrics.presentTime.Add(presentEnd - presentStart);
+            metrics.frameTime.Add(presentEnd - lastFrameMicros);
+            lastFrameMicros = presentEnd;
 
-        if (dt > cycleDelay) {  // If it is time to do an instruction
-            lastCycleTime = currentTime;
-            chip8.Cycle();
-            platform.Update(chip8.video, videoPitch);
+            if (presentEnd - lastReportMicros >= 1000000) {  // Report once a second
+                lastReportMicros = presentEnd;
+                string report = metrics.Report();
+                if (metricsFilename) {metrics.Export(metricsFilename);}
+                if (showOverlay) {platform.SetOverlay(report);}
+            }
+        } else {
+            platform.Update(shownVideo, videoPitch);
         }
+        executed = 0;
     }
 
     return 0;
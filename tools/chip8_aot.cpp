@@ -0,0 +1,279 @@
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+#include "../Hash.h"
+
+/*
+Ahead-of-time compiler: turns a ROM into C++ with one function per basic block, which is then built into a
+shared library and loaded with LoadAotModule() (or --aot in main.cpp). See README.md for the full steps.
+
+The reference for what every opcode does is Chip8.cpp. Simple opcodes are written out inline here, and anything
+with quirks or lots of code (drawing, RNG, BCD, 8xy5, ...) is handed back to the interpreter through Execute,
+so the compiled code always does exactly what the interpreter would.
+*/
+/* CLI ARGS:
+    1 - The file to run (this file)
+    2 - ROM file to compile
+    3 - C++ file to write
+*/
+
+const unsigned int START_ADDR = 0x200;          // ROMs are loaded here
+const unsigned int MEMORY_SIZE = 4096;
+
+uint8_t memory[MEMORY_SIZE];                    // The ROM, laid out as the Chip8 would see it
+size_t romSize = 0;
+
+// Where control can go after an instruction
+struct Flow {
+    bool endsBlock;                             // Jumps, skips, calls, returns and anything else that doesn't just fall through
+    std::vector<uint32_t> targets;              // Addresses it can go to that are known now (empty if it depends on runtime state)
+};
+
+// Only instructions that sit entirely inside the ROM are compiled, everything else is left to the interpreter
+bool InRom(uint32_t address) {
+    return address >= START_ADDR && address + 1 < START_ADDR + romSize;
+}
+
+uint16_t OpcodeAt(uint32_t address) {
+    return (memory[address] << 8u) | memory[address + 1];
+}
+
+// NOTE: The interpreter decodes the 0, 8 and E groups by their last nibble and the F group by its last byte, so we do too
+Flow Analyse(uint32_t address, uint16_t op) {
+    uint32_t next = address + 2;
+    uint32_t nnn = op & 0x0FFFu;
+    switch (op >> 12u) {
+        case 0x0: if ((op & 0x000Fu) == 0xE) {return {true, {}};} break;      // 00EE return, target is on the stack
+        case 0x1: return {true, {nnn}};                                         // Jump
+        case 0x2: return {true, {nnn, next}};                                   // Call, and where it returns to
+        case 0x3: case 0x4: case 0x5: case 0x9: return {true, {next, next + 2}};  // Skips
+        case 0xB: return {true, {}};                                            // Jump to V0 + nnn
+        case 0xE:
+            if ((op & 0x000Fu) == 0x1 || (op & 0x000Fu) == 0xE) {return {true, {next, next + 2}};}  // Key skips
+            break;
+        case 0xF: if ((op & 0x00FFu) == 0x0A) {return {true, {address, next}};} break;  // Key wait, might repeat itself
+    }
+    return {false, {}};
+}
+
+// Work out every reachable instruction in the ROM, and which ones start a block
+void Discover(std::set<uint32_t>& code, std::set<uint32_t>& leaders) {
+    std::vector<uint32_t> work = {START_ADDR};
+    leaders.insert(START_ADDR);
+    while (!work.empty()) {
+        uint32_t address = work.back();
+        work.pop_back();
+        if (!InRom(address) || code.count(address)) {continue;}
+        code.insert(address);
+
+        Flow flow = Analyse(address, OpcodeAt(address));
+        if (!flow.endsBlock) {
+            work.push_back(address + 2);
+        }
+        for (uint32_t target : flow.targets) {
+            leaders.insert(target);
+            work.push_back(target);
+        }
+    }
+}
+
+std::string Hex(uint32_t value, int digits) {
+    char text[16];
+    snprintf(text, sizeof(text), "0x%0*X", digits, value);
+    return text;
+}
+
+std::string BlockName(uint32_t address) {
+    char text[16];
+    snprintf(text, sizeof(text), "B_%03X", address);
+    return text;
+}
+
+/* ------------------------ CODE GENERATION ---------------------- */
+std::set<uint32_t> code;                        // Addresses of every compiled instruction
+std::set<uint32_t> blockStarts;                 // Addresses that have a block function
+
+// Write one instruction. remaining is how many instructions of the block come after this one
+void EmitInstruction(std::ofstream& out, uint32_t address, uint16_t op, uint32_t remaining) {
+    std::string x = Hex((op & 0x0F00u) >> 8u, 1);
+    std::string y = Hex((op & 0x00F0u) >> 4u, 1);
+    std::string kk = Hex(op & 0x00FFu, 2);
+    std::string nnn = Hex(op & 0x0FFFu, 3);
+    uint32_t next = address + 2;
+    std::string vx = "c.registers[" + x + "]";
+    std::string vy = "c.registers[" + y + "]";
+    std::string interpret = "c.pc = " + Hex(next, 3) + "; execute(c, " + Hex(op, 4) + "); Tick(c);";
+
+    out << "    // " << Hex(address, 3) << ": " << Hex(op, 4) << "\n    ";
+    switch (op >> 12u) {
+        case 0x0:
+            if ((op & 0x000Fu) == 0x0) {out << "memset(c.video, 0, sizeof(c.video)); c.dirtyPages |= ALL_PAGES_DIRTY & ~((1ull << MEMORY_PAGE_COUNT) - 1); Tick(c);";}  // Same video pages OP_00E0 marks
+            else if ((op & 0x000Fu) == 0xE) {out << "--c.sp; c.pc = c.stack[c.sp]; Tick(c); return budget;";}
+            else {out << "Tick(c);";}           // OP_NULL
+            break;
+        case 0x1:
+            out << "c.pc = " << nnn << "; Tick(c); return budget;";
+            break;
+        case 0x2:
+            out << "c.stack[c.sp] = " << Hex(next, 3) << "; ++c.sp; c.pc = " << nnn << "; Tick(c); return budget;";
+            break;
+        case 0x3: case 0x4: case 0x5: case 0x9: {
+            std::string test = (op >> 12u) == 0x3 ? vx + " == " + kk
+                             : (op >> 12u) == 0x4 ? vx + " != " + kk
+                             : (op >> 12u) == 0x5 ? vx + " == " + vy
+                             : vx + " != " + vy;
+            out << "Tick(c);\n    if (" << test << ") {c.pc = " << Hex(next + 2, 3) << "; return budget;}\n"
+                << "    c.pc = " << Hex(next, 3) << "; return budget;";
+        } break;
+        case 0x6: out << vx << " = " << kk << "; Tick(c);"; break;
+        case 0x7: out << vx << " += " << kk << "; Tick(c);"; break;
+        case 0x8:
+            switch (op & 0x000Fu) {
+                case 0x0: out << vx << " = " << vy << "; Tick(c);"; break;
+                case 0x1: out << vx << " |= " << vy << "; Tick(c);"; break;
+                case 0x2: out << vx << " &= " << vy << "; Tick(c);"; break;
+                case 0x3: out << vx << " ^= " << vy << "; Tick(c);"; break;
+                case 0x4: out << "{uint16_t sum = " << vx << " + " << vy << "; c.registers[0xF] = sum > 255u ? 1 : 0; " << vx << " = sum & 0xFFu;} Tick(c);"; break;
+                case 0x6: out << "c.registers[0xF] = " << vx << " & 0x1u; " << vx << " >>= 1; Tick(c);"; break;
+                case 0x7: out << "c.registers[0xF] = " << vx << " < " << vy << " ? 1 : 0; " << vx << " = " << vy << " - " << vx << "; Tick(c);"; break;
+                case 0xE: out << "c.registers[0xF] = (" << vx << " & 0x80u) >> 7u; " << vx << " <<= 1; Tick(c);"; break;
+                case 0x5: out << interpret; break;
+                default: out << "Tick(c);"; break;  // OP_NULL
+            }
+            break;
+        case 0xA: out << "c.index = " << nnn << "; Tick(c);"; break;
+        case 0xB: out << "c.pc = c.registers[0] + " << nnn << "; Tick(c); return budget;"; break;
+        case 0xE:
+            if ((op & 0x000Fu) == 0x1 || (op & 0x000Fu) == 0xE) {out << interpret << " return budget;";}
+            else {out << "Tick(c);";}           // OP_NULL
+            break;
+        case 0xF:
+            switch (op & 0x00FFu) {
+                case 0x07: out << vx << " = c.delayTimer; Tick(c);"; break;
+                case 0x0A: out << interpret << " return budget;"; break;
+                case 0x15: out << "c.delayTimer = " << vx << "; Tick(c);"; break;
+                case 0x18: out << "c.soundTimer = " << vx << "; Tick(c);"; break;
+                case 0x1E: out << "c.index += " << vx << "; Tick(c);"; break;
+                case 0x33: case 0x55:           // These write memory, and might have just overwritten compiled code
+                    out << interpret << "\n    if (!c.aot) {return budget + " << remaining << ";}";
+                    break;
+                default:
+                    if ((op & 0x00FFu) > 0x65 || (op & 0x00FFu) == 0x29 || (op & 0x00FFu) == 0x65) {out << interpret;}
+                    else {out << "Tick(c);";}   // OP_NULL
+                    break;
+            }
+            break;
+        default: out << interpret; break;       // Cxkk and Dxyn
+    }
+    out << "\n";
+}
+
+// A block runs from its start until something ends it, or until it runs into the start of another block
+std::vector<uint32_t> BlockInstructions(uint32_t start) {
+    std::vector<uint32_t> instructions;
+    uint32_t address = start;
+    while (true) {
+        instructions.push_back(address);
+        if (Analyse(address, OpcodeAt(address)).endsBlock) {break;}
+        address += 2;
+        if (!code.count(address) || blockStarts.count(address)) {break;}
+    }
+    return instructions;
+}
+
+// A block ends by setting pc and returning budget, so Chip8::Run looks up and runs the next block.
+// Calling the next block directly would nest one C++ call per block, and a loop would overflow the stack
+void EmitBlock(std::ofstream& out, uint32_t start) {
+    std::vector<uint32_t> instructions = BlockInstructions(start);
+    uint32_t count = instructions.size();
+
+    out << "static uint32_t " << BlockName(start) << "(Chip8& c, uint32_t budget) {\n";
+    out << "    if (budget < " << count << ") {return budget;}\n";
+    out << "    budget -= " << count << ";\n";
+    for (uint32_t i = 0; i < count; ++i) {
+        EmitInstruction(out, instructions[i], OpcodeAt(instructions[i]), count - i - 1);
+    }
+    uint32_t last = instructions.back();
+    if (!Analyse(last, OpcodeAt(last)).endsBlock) {  // Fell into another block (or off the end of the compiled code)
+        out << "    c.pc = " << Hex(last + 2, 3) << "; return budget;\n";
+    }
+    out << "}\n\n";
+}
+
+int main(int argc, char const* argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <ROM> <Output.cpp>\n", argv[0]);
+        return 1;
+    }
+
+    std::ifstream rom(argv[1], std::ios::binary);
+    if (!rom.is_open()) {
+        fprintf(stderr, "Could not open %s\n", argv[1]);
+        return 1;
+    }
+    rom.read(reinterpret_cast<char*>(&memory[START_ADDR]), MEMORY_SIZE - START_ADDR);
+    romSize = rom.gcount();
+    if (rom.peek() != EOF) {
+        fprintf(stderr, "%s is too big to be a ROM\n", argv[1]);
+        return 1;
+    }
+
+    std::set<uint32_t> leaders;
+    Discover(code, leaders);
+    for (uint32_t leader : leaders) {
+        if (code.count(leader)) {blockStarts.insert(leader);}  // Targets outside the ROM don't get a block
+    }
+    if (code.empty()) {                         // E.g. an empty ROM, there would be nothing to put in the module (and code[] would be empty, which C++ doesn't allow)
+        fprintf(stderr, "No code found in %s, nothing to compile\n", argv[1]);
+        return 1;
+    }
+
+    std::ofstream out(argv[2]);
+    if (!out.is_open()) {
+        fprintf(stderr, "Could not write %s\n", argv[2]);
+        return 1;
+    }
+
+    out << "// Generated by tools/chip8_aot.cpp from " << argv[1] << ", do not edit\n";
+    out << "#include \"Chip8.h\"\n#include \"Aot.h\"\n#include <string.h>\n\n";
+    out << "static AotExecute execute;  // Interpreter fallback, handed over by LoadAotModule\n\n";
+    out << "static inline void Tick(Chip8& c) {\n"
+        << "    if (c.delayTimer > 0) {--c.delayTimer;}\n"
+        << "    if (c.soundTimer > 0) {--c.soundTimer;}\n"
+        << "}\n\n";
+
+    for (uint32_t start : blockStarts) {out << "static uint32_t " << BlockName(start) << "(Chip8& c, uint32_t budget);\n";}
+    out << "\n";
+    for (uint32_t start : blockStarts) {EmitBlock(out, start);}
+
+    out << "static uint8_t const rom[] = {";
+    for (size_t i = 0; i < romSize; ++i) {out << (i % 16 == 0 ? "\n    " : " ") << Hex(memory[START_ADDR + i], 2) << ",";}
+    out << "\n};\n\n";
+    out << "static uint16_t const code[] = {";
+    size_t i = 0;
+    for (uint32_t address : code) {out << (i++ % 16 == 0 ? "\n    " : " ") << Hex(address, 3) << ",";}
+    out << "\n};\n\n";
+
+    out << "static AotBlock blocks[4096];\nstatic uint8_t codeMap[4096];\nstatic AotModule module;\n\n";
+    out << "extern \"C\" __attribute__((visibility(\"default\"))) AotModule const* chip8_aot_module(AotExecute interpreter) {\n";
+    out << "    execute = interpreter;\n";
+    for (uint32_t start : blockStarts) {out << "    blocks[" << Hex(start, 3) << "] = " << BlockName(start) << ";\n";}
+    out << "    for (uint16_t address : code) {\n"
+        << "        codeMap[address] = 1;\n"
+        << "        codeMap[(address + 1) & 0x0FFFu] = 1;\n"
+        << "    }\n";
+    out << "    module.abiVersion = AOT_ABI_VERSION;\n"
+        << "    module.chip8Size = sizeof(Chip8);\n"
+        << "    module.romHash = 0x" << std::hex << Fnv1a(&memory[START_ADDR], romSize) << std::dec << "ull;\n"
+        << "    module.romSize = " << romSize << ";\n"
+        << "    module.rom = rom;\n"
+        << "    module.blocks = blocks;\n"
+        << "    module.codeMap = codeMap;\n"
+        << "    return &module;\n"
+        << "}\n";
+
+    printf("%zu instructions in %zu blocks\n", code.size(), blockStarts.size());
+    return 0;
+}
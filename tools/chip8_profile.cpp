@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include "../Chip8.h"
+
+/*
+Profiles which pairs of instructions run back to back the most across a set of ROMs, which is what the
+fused handlers in Chip8.cpp were picked from. With --verify it instead checks that fusion gives exactly
+the same results as running one instruction at a time, and with --bench it times Run() with and without it.
+*/
+/* CLI ARGS:
+    1 - The file to run (this file)
+    2 - Number of cycles to run each ROM for
+    3... - ROM files (add --verify or --bench before them to check or time fusion instead of profiling)
+*/
+
+const uint32_t SEED = 1;                        // Fixed seed so every run sees the same random numbers
+
+// Name an opcode by its pattern, e.g. 0x6A02 -> "6xkk" and 0xF107 -> "Fx07"
+std::string Pattern(uint16_t op) {
+    char text[8];
+    switch (op >> 12u) {
+        case 0x0: return (op & 0x000Fu) == 0xE ? "00EE" : (op & 0x000Fu) == 0x0 ? "00E0" : "0nnn";
+        case 0x1: return "1nnn";
+        case 0x2: return "2nnn";
+        case 0x3: return "3xkk";
+        case 0x4: return "4xkk";
+        case 0x5: return "5xy0";
+        case 0x6: return "6xkk";
+        case 0x7: return "7xkk";
+        case 0x8: snprintf(text, sizeof(text), "8xy%X", op & 0x000Fu); return text;
+        case 0x9: return "9xy0";
+        case 0xA: return "Annn";
+        case 0xB: return "Bnnn";
+        case 0xC: return "Cxkk";
+        case 0xD: return "Dxyn";
+        case 0xE: snprintf(text, sizeof(text), "Ex%02X", op & 0x00FFu); return text;
+        default: snprintf(text, sizeof(text), "Fx%02X", op & 0x00FFu); return text;
+    }
+}
+
+// Whether an instruction can move the PC (jumps, calls, skips, Fx0A waiting), so the one after it doesn't always run
+// and a pair starting with it can't be fused
+bool MovesPc(std::string const& pattern) {
+    return pattern == "00EE" || pattern == "Fx0A" || strchr("123459BE", pattern[0]) != nullptr;
+}
+
+// Count every pair of instructions where the second one came straight after the first (no jump or skip in between)
+void Profile(Chip8& chip8, uint32_t cycles, std::map<std::string, uint64_t>& pairs) {
+    uint16_t lastPc = 0xFFFF;
+    uint16_t lastOpcode = 0;
+    for (uint32_t i = 0; i < cycles; ++i) {
+        uint16_t pc = chip8.pc;
+        chip8.Cycle();
+        if (pc == lastPc + 2) {
+            ++pairs[Pattern(lastOpcode) + "+" + Pattern(chip8.opcode)];
+        }
+        lastPc = pc;
+        lastOpcode = chip8.opcode;
+    }
+}
+
+// Run the same ROM with and without fusion in uneven chunks, and compare the whole state after every chunk
+bool Verify(char const* rom, uint32_t cycles) {
+    Chip8 plain(SEED);
+    Chip8 fused(SEED);
+    plain.LoadROM(rom);
+    fused.LoadROM(rom);
+    fused.SetFusion(true);
+
+    uint32_t done = 0;
+    uint32_t chunk = 1;
+    while (done < cycles) {
+        chunk = chunk % 37 + 1;                 // Vary the chunk size so pairs get split across chunks too
+        plain.Run(chunk);
+        fused.Run(chunk);
+        done += chunk;
+        if (plain.pc != fused.pc || plain.index != fused.index || plain.sp != fused.sp ||
+            plain.delayTimer != fused.delayTimer || plain.soundTimer != fused.soundTimer || plain.opcode != fused.opcode ||
+            memcmp(plain.registers, fused.registers, sizeof(plain.registers)) != 0 ||
+            memcmp(plain.stack, fused.stack, sizeof(plain.stack)) != 0 ||
+            memcmp(plain.memory, fused.memory, sizeof(plain.memory)) != 0 ||
+            memcmp(plain.video, fused.video, sizeof(plain.video)) != 0) {
+            printf("%s: MISMATCH after %u cycles (pc %03X vs %03X)\n", rom, done, plain.pc, fused.pc);
+            return false;
+        }
+    }
+    printf("%s: identical over %u cycles\n", rom, done);
+    return true;
+}
+
+// Milliseconds for Run() to get through cycles instructions, in frame-sized chunks like main.cpp
+double TimeRun(char const* rom, uint32_t cycles, bool fuse) {
+    Chip8 chip8(SEED);
+    chip8.LoadROM(rom);
+    chip8.SetFusion(fuse);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t done = 0; done < cycles; done += 1000) {chip8.Run(1000);}
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Bench(char const* rom, uint32_t cycles) {
+    TimeRun(rom, cycles / 10, false);           // Warm up the caches and the CPU clock first
+    double plain = TimeRun(rom, cycles, false);
+    double fused = TimeRun(rom, cycles, true);
+    printf("%s: plain %.0f ms, fused %.0f ms (%+.1f%%)\n", rom, plain, fused, 100.0 * (plain - fused) / plain);
+}
+
+int main(int argc, char const* argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <Cycles> [--verify | --bench] <ROM>...\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t cycles = std::stoul(argv[1]);
+    int first = 2;
+    bool verify = std::string(argv[2]) == "--verify";
+    bool bench = std::string(argv[2]) == "--bench";
+    if (verify || bench) {++first;}
+
+    if (verify) {
+        bool allPassed = true;
+        for (int i = first; i < argc; ++i) {
+            if (!Verify(argv[i], cycles)) {allPassed = false;}
+        }
+        return allPassed ? 0 : 1;
+    }
+    if (bench) {
+        for (int i = first; i < argc; ++i) {Bench(argv[i], cycles);}
+        return 0;
+    }
+
+    std::map<std::string, uint64_t> pairs;
+    uint64_t total = 0;
+    for (int i = first; i < argc; ++i) {
+        Chip8 chip8(SEED);
+        if (!chip8.LoadROM(argv[i])) {
+            fprintf(stderr, "Could not load %s\n", argv[i]);
+            continue;
+        }
+        Profile(chip8, cycles, pairs);
+    }
+
+    std::vector<std::pair<uint64_t, std::string>> sorted;
+    for (auto const& pair : pairs) {
+        sorted.push_back({pair.second, pair.first});
+        total += pair.second;
+    }
+    std::sort(sorted.rbegin(), sorted.rend());  // Most common first
+
+    for (size_t i = 0; i < sorted.size() && i < 20; ++i) {
+        std::string const& pair = sorted[i].second;
+        printf("%-12s %10llu  %5.1f%%%s\n", pair.c_str(), (unsigned long long)sorted[i].first, 100.0 * sorted[i].first / total,
+               MovesPc(pair.substr(0, 4)) ? "  (can't fuse, the first moves the PC)" : "");
+    }
+    return 0;
+}
@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../Chip8.h"
+#include "../Hash.h"
+
+/*
+Golden-frame regression runner. Every ROM in a folder is run headless for a fixed number of frames (one
+ROM per thread, on as many cores as there are), and a hash of the display and registers is taken at
+checkpoints. These are compared with the hashes stored next to the ROM, so any change to an opcode handler
+can be checked against the whole corpus in one go.
+
+For a ROM called game.ch8:
+    game.input  - (optional) scripted input, one "<frame> <key> <0 or 1>" per line, e.g. "120 5 1" presses key 5 at frame 120
+    game.golden - the expected hashes, one "<frame> <hash>" per line, written by --update
+*/
+/* CLI ARGS:
+    1 - The file to run (this file)
+    2 - Folder of ROMs (e.g. ROMS)
+    Optional:
+    --update - Write new golden files instead of checking them
+    --fuse - Run with instruction fusion on (the hashes must still match)
+    --frames <n> - Frames to run each ROM for (default 600)
+    --cycles <n> - Instructions per frame (default 10)
+    --threads <n> - Number of worker threads (default: one per core)
+*/
+
+const uint32_t SEED = 1;                        // Fixed RNG seed, so Cxkk gives the same numbers every run
+const uint32_t CHECKPOINT_FRAMES = 60;          // Take a hash this often (and on the last frame)
+
+struct Options {
+    bool update = false;
+    bool fuse = false;
+    uint32_t frames = 600;
+    uint32_t cyclesPerFrame = 10;
+    unsigned int threads = 0;
+};
+
+struct InputStep {
+    uint32_t frame;
+    uint8_t key;
+    uint8_t pressed;
+};
+
+struct Result {
+    std::string rom;
+    std::string status;                         // "ok", "FAIL", "NEW", "UPDATED" or an error
+    std::string detail;
+    bool passed;
+};
+
+typedef std::map<uint32_t, uint64_t> Checkpoints;  // Frame -> hash
+
+std::vector<InputStep> ReadInput(std::filesystem::path const& path) {
+    std::vector<InputStep> steps;
+    std::ifstream file(path);
+    uint32_t frame, key, pressed;
+    while (file >> frame >> key >> pressed) {
+        steps.push_back({frame, static_cast<uint8_t>(key & 0xFu), static_cast<uint8_t>(pressed ? 1 : 0)});
+    }
+    std::stable_sort(steps.begin(), steps.end(), [](InputStep const& a, InputStep const& b) {return a.frame < b.frame;});
+    return steps;
+}
+
+bool ReadGolden(std::filesystem::path const& path, Checkpoints& golden) {
+    std::ifstream file(path);
+    if (!file.is_open()) {return false;}
+    uint32_t frame;
+    std::string hash;
+    while (file >> frame >> hash) {
+        golden[frame] = std::stoull(hash, nullptr, 16);
+    }
+    return true;
+}
+
+bool WriteGolden(std::filesystem::path const& path, Checkpoints const& checkpoints) {
+    std::ofstream file(path);
+    if (!file.is_open()) {return false;}
+    for (auto const& checkpoint : checkpoints) {
+        char line[64];
+        snprintf(line, sizeof(line), "%u %016llx\n", checkpoint.first, (unsigned long long)checkpoint.second);
+        file << line;
+    }
+    return static_cast<bool>(file);
+}
+
+// Hash of what the player sees plus the registers, which catches most logic changes before they reach the screen
+uint64_t StateHash(Chip8 const& chip8) {
+    uint64_t hash = Fnv1a(chip8.video, sizeof(chip8.video));
+    return Fnv1a(chip8.registers, sizeof(chip8.registers), hash);
+}
+
+Result RunRom(std::filesystem::path const& romPath, Options const& options) {
+    Result result{romPath.filename().string(), "", "", false};
+
+    Chip8 chip8(SEED);
+    if (!chip8.LoadROM(romPath.string().c_str())) {
+        result.status = "ERROR";
+        result.detail = "could not load ROM";
+        return result;
+    }
+    chip8.SetFusion(options.fuse);
+
+    std::filesystem::path inputPath = romPath;
+    std::vector<InputStep> input = ReadInput(inputPath.replace_extension(".input"));
+    size_t nextInput = 0;
+
+    Checkpoints checkpoints;
+    for (uint32_t frame = 1; frame <= options.frames; ++frame) {
+        while (nextInput < input.size() && input[nextInput].frame <= frame) {  // Keys change at the start of their frame
+            chip8.keypad[input[nextInput].key] = input[nextInput].pressed;
+            ++nextInput;
+        }
+        chip8.Run(options.cyclesPerFrame);
+        if (frame % CHECKPOINT_FRAMES == 0 || frame == options.frames) {
+            checkpoints[frame] = StateHash(chip8);
+        }
+    }
+
+    std::filesystem::path goldenPath = romPath;
+    goldenPath.replace_extension(".golden");
+    if (options.update) {
+        result.passed = WriteGolden(goldenPath, checkpoints);
+        result.status = result.passed ? "UPDATED" : "ERROR";
+        if (!result.passed) {result.detail = "could not write " + goldenPath.string();}
+        return result;
+    }
+
+    Checkpoints golden;
+    if (!ReadGolden(goldenPath, golden)) {
+        result.status = "NEW";
+        result.detail = "no golden file, run with --update to create one";
+        return result;
+    }
+    for (auto const& checkpoint : checkpoints) {
+        auto expected = golden.find(checkpoint.first);
+        if (expected == golden.end()) {continue;}   // Golden was made with fewer frames, only compare what it has
+        if (expected->second != checkpoint.second) {
+            result.status = "FAIL";
+            result.detail = "first differs at frame " + std::to_string(checkpoint.first);
+            return result;
+        }
+    }
+    result.status = "ok";
+    result.passed = true;
+    return result;
+}
+
+int main(int argc, char const* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <ROMDir> [--update] [--fuse] [--frames <n>] [--cycles <n>] [--threads <n>]\n", argv[0]);
+        return 1;
+    }
+
+    Options options;
+    for (int i = 2; i < argc; ++i) {
+        std::string option = argv[i];
+        if (option == "--update") {options.update = true;}
+        else if (option == "--fuse") {options.fuse = true;}
+        else if (option == "--frames" && i + 1 < argc) {options.frames = std::stoul(argv[++i]);}
+        else if (option == "--cycles" && i + 1 < argc) {options.cyclesPerFrame = std::stoul(argv[++i]);}
+        else if (option == "--threads" && i + 1 < argc) {options.threads = std::stoul(argv[++i]);}
+        else {
+            fprintf(stderr, "Unknown option: %s\n", option.c_str());
+            return 1;
+        }
+    }
+
+    std::vector<std::filesystem::path> roms;
+    std::error_code error;
+    for (auto const& entry : std::filesystem::directory_iterator(argv[1], error)) {
+        if (entry.path().extension() == ".ch8") {roms.push_back(entry.path());}
+    }
+    if (error) {
+        fprintf(stderr, "Could not read %s\n", argv[1]);
+        return 1;
+    }
+    std::sort(roms.begin(), roms.end());
+
+    // Workers take the next ROM off a shared counter until there are none left
+    std::vector<Result> results(roms.size());
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < roms.size(); i = next++) {
+            results[i] = RunRom(roms[i], options);
+        }
+    };
+    unsigned int threadCount = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < threadCount && i < roms.size(); ++i) {threads.emplace_back(worker);}
+    for (auto& thread : threads) {thread.join();}
+
+    size_t failed = 0;
+    for (auto const& result : results) {
+        printf("%-8s %s%s%s\n", result.status.c_str(), result.rom.c_str(), result.detail.empty() ? "" : ": ", result.detail.c_str());
+        if (!result.passed) {++failed;}
+    }
+    printf("%zu of %zu ROMs passed\n", results.size() - failed, results.size());
+    return failed == 0 ? 0 : 1;
+}
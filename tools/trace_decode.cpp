@@ -0,0 +1,47 @@
+#include <cstdio>
+#include <string.h>
+#include "../Tracer.h"
+
+// Offline decoder for Tracer dumps: prints one line per instruction with the registers it changed
+/* CLI ARGS:
+    1 - The file to run (this file)
+    2 - Trace dump to decode
+*/
+int main(int argc, char const* argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <TraceDump>\n", argv[0]);
+        return 1;
+    }
+
+    FILE* file = fopen(argv[1], "rb");
+    if (!file) {
+        fprintf(stderr, "Could not open %s\n", argv[1]);
+        return 1;
+    }
+
+    TraceDumpHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0) {
+        fprintf(stderr, "%s is not a trace dump\n", argv[1]);
+        return 1;
+    }
+    if (header.version != TRACE_VERSION || header.recordSize != sizeof(TraceRecord)) {
+        fprintf(stderr, "%s was written by an incompatible version\n", argv[1]);
+        return 1;
+    }
+
+    TraceRecord record;
+    for (uint64_t i = 0; i < header.count; ++i) {
+        if (fread(&record, sizeof(record), 1, file) != 1) {
+            fprintf(stderr, "Dump is truncated after %llu records\n", (unsigned long long)i);
+            break;
+        }
+        printf("%10llu  PC=%03X  OP=%04X  I=%03X ", (unsigned long long)(header.firstSequence + i), record.pc, record.opcode, record.index);
+        for (unsigned int r = 0; r < 16; ++r) {     // Only print the registers that changed
+            if (record.changedRegisters & (1u << r)) {printf(" V%X=%02X", r, record.registers[r]);}
+        }
+        printf("\n");
+    }
+
+    fclose(file);
+    return 0;
+}